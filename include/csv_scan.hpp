@@ -0,0 +1,24 @@
+#ifndef ENBT_CSV_SCAN_H
+#define ENBT_CSV_SCAN_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Bit i is set when byte i of a 64-byte block is a field delimiter
+// (',', '|' or ';') or a newline respectively.
+struct csv_block_masks {
+	std::uint64_t delims;
+	std::uint64_t newlines;
+};
+
+// Classify 64 readable bytes starting at block. Uses AVX2 or SSE2 when the
+// CPU supports them (chosen once at runtime) and a scalar loop otherwise.
+csv_block_masks scan_csv_block(const char* block);
+
+// Portable reference implementation, also used for the tail of the input
+csv_block_masks scan_csv_block_scalar(const char* block);
+
+// Name of the implementation scan_csv_block dispatches to ("avx2", "sse2" or "scalar")
+const char* csv_scan_backend();
+
+#endif
@@ -1,6 +1,11 @@
 #ifndef ENBT_PARSE_H
 #define ENBT_PARSE_H
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -11,9 +16,37 @@ struct nbtserver {
 	bool accept_textures;
 };
 
+// Java Edition servers.dat is big-endian NBT. Bedrock NBT is little-endian
+// and may carry the 8-byte level.dat header, which is detected and skipped.
+enum class nbt_flavor {
+	java,
+	bedrock,
+};
+
 std::vector<nbtserver> parse_servers_json(const std::string& content);
 std::vector<nbtserver> parse_servers_toml(const std::string& content);
-std::vector<nbtserver> parse_servers_csv(const std::string& content);
-std::vector<nbtserver> parse_servers_dat(const std::string& filepath);
+// threads == 0 uses ENBT_THREADS, or the hardware concurrency when unset
+std::vector<nbtserver> parse_servers_csv(const std::string& content, unsigned threads = 0);
+// Large uncompressed files are decoded on several threads; threads works
+// as for parse_servers_csv
+std::vector<nbtserver> parse_servers_dat(const std::string& filepath, nbt_flavor flavor = nbt_flavor::java, unsigned threads = 0);
+std::vector<nbtserver> parse_servers_dat(std::span<const std::byte> data, nbt_flavor flavor = nbt_flavor::java, unsigned threads = 0);
+
+// Stream the servers of a servers.dat to on_server one at a time instead of
+// collecting them. Returns false if the file could not be read; servers
+// decoded before the error have already been delivered.
+bool read_servers_dat(const std::string& filepath, const std::function<void(nbtserver&&)>& on_server, nbt_flavor flavor = nbt_flavor::java);
+
+// Decode the one servers list entry whose compound payload starts at offset
+// in the uncompressed data (see server_index). Missing fields are left empty
+std::optional<nbtserver> parse_server_at(std::span<const std::byte> data, std::uint64_t offset, nbt_flavor flavor = nbt_flavor::java);
+
+// Check that a servers.dat (or any NBT file) is well-formed without decoding
+// it, printing "OK" or the first problem and its byte offset
+bool check_servers_dat(const std::string& filepath, nbt_flavor flavor = nbt_flavor::java);
+
+// Worker count for the parallel parsers: requested if non-zero, otherwise
+// ENBT_THREADS, otherwise std::thread::hardware_concurrency()
+unsigned resolve_thread_count(unsigned requested);
 
 #endif
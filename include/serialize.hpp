@@ -1,13 +1,45 @@
 #ifndef ENBT_SERIALIZE_H
 #define ENBT_SERIALIZE_H
 
+#include <cstddef>
+#include <ostream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include "parse.hpp"
 
-// Convert vector<nbtserver> to formatted strings
+// pretty is 2-space indented, compact has no whitespace at all
+enum class json_layout { pretty, compact };
+
+// Convert vector<nbtserver> to formatted strings. The JSON writers throw
+// std::invalid_argument for strings that aren't valid UTF-8, as dump() does.
 std::string serialize_servers_csv(const std::vector<nbtserver>& servers);
-std::string serialize_servers_json(const std::vector<nbtserver>& servers);
+std::string serialize_servers_json(const std::vector<nbtserver>& servers, json_layout layout = json_layout::pretty);
 std::string serialize_servers_toml(const std::vector<nbtserver>& servers);
 
+// Same output, written to out as each server is serialized
+void serialize_servers_csv(const std::vector<nbtserver>& servers, std::ostream& out);
+void serialize_servers_json(const std::vector<nbtserver>& servers, std::ostream& out, json_layout layout = json_layout::pretty);
+void serialize_servers_toml(const std::vector<nbtserver>& servers, std::ostream& out);
+
+// Incremental serializer for producers that never hold the whole list.
+// Call write() once per server and finish() once at the end.
+class server_serializer {
+public:
+	// format is "csv", "json" or "toml"; layout only applies to json
+	server_serializer(std::ostream& out, std::string_view format, json_layout layout = json_layout::pretty);
+
+	void write(const nbtserver& server);
+	void finish();
+
+private:
+	// Parsed once from the format string; unknown formats write nothing
+	enum class output_format { csv, json, toml, unknown };
+
+	std::ostream& out;
+	output_format format;
+	json_layout layout;
+	std::size_t count = 0;
+};
+
 #endif
@@ -0,0 +1,132 @@
+#ifndef ENBT_SERVER_INDEX_H
+#define ENBT_SERVER_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "parse.hpp"
+#include "NBTReader.h"
+
+// Where one entry of the servers list sits in the uncompressed NBT data.
+// offset is the start of the entry's compound payload and length runs
+// through its TAG_End. name, ip and icon point at the length prefix of
+// those string payloads and accept_textures at its byte; each is 0 when
+// the entry has no such field.
+struct server_offsets {
+	std::uint64_t offset;
+	std::uint64_t length;
+	std::uint64_t name;
+	std::uint64_t ip;
+	std::uint64_t icon;
+	std::uint64_t accept_textures;
+};
+
+// Scan the "servers" list structurally, without decoding any strings, and
+// record every entry, including ones parse_servers_dat would skip for
+// missing fields. Prints the error to stderr and returns nullopt on
+// malformed data.
+std::optional<std::vector<server_offsets>> build_server_index(std::span<const std::byte> data, nbt_flavor flavor = nbt_flavor::java);
+
+// The same scan, returning the error instead of printing it. gzip data is
+// refused with NotSeekable; inflate it first, as server_index::open does.
+NBT::Result<std::vector<server_offsets>> scan_server_index(std::span<const std::byte> data, nbt_flavor flavor = nbt_flavor::java);
+
+// Sidecar file an index is persisted to: "<path>.idx"
+std::string server_index_path(const std::string& path);
+
+// Random access to the entries of a servers.dat. open() loads the sidecar
+// index when it was written for the same file (size and modification time)
+// and otherwise scans the file once. gzip files are inflated into memory,
+// since offsets into a deflate stream can't be seeked to.
+class server_index {
+public:
+	// Returns false, after printing why to stderr, if the file can't be indexed.
+	// With persist, a freshly built index is saved to the sidecar file.
+	bool open(const std::string& path, nbt_flavor flavor = nbt_flavor::java, bool persist = false);
+
+	std::size_t size() const { return entries.size(); }
+	const server_offsets& offsets(std::size_t i) const { return entries[i]; }
+	// The uncompressed NBT the offsets refer to
+	std::span<const std::byte> bytes() const { return data; }
+
+	// Read one field straight from the data; empty if the entry lacks it.
+	// Views stay valid while the index is open.
+	std::string_view name(std::size_t i) const;
+	std::string_view ip(std::size_t i) const;
+	std::string_view icon(std::size_t i) const;
+	bool accept_textures(std::size_t i) const;
+	// Decode entry i completely
+	std::optional<nbtserver> read(std::size_t i) const;
+
+private:
+	std::string_view string_at(std::uint64_t offset) const;
+
+	NBT::MappedFile mapping;
+	std::vector<std::byte> inflated;
+	std::span<const std::byte> data;
+	std::vector<server_offsets> entries;
+	nbt_flavor flavor = nbt_flavor::java;
+};
+
+// One entry of a server_list_view. Nothing is decoded up front: each field
+// is read from the mapping when asked for, as a view that stays valid
+// while the list is open.
+class server_view {
+public:
+	server_view(const server_index& index, std::size_t i) : index(&index), i(i) {}
+
+	std::string_view name() const { return index->name(i); }
+	std::string_view ip() const { return index->ip(i); }
+	std::string_view icon() const { return index->icon(i); }
+	bool accept_textures() const { return index->accept_textures(i); }
+	// Has the fields parse_servers_dat requires to keep an entry
+	bool complete() const { return !name().empty() && !ip().empty(); }
+	// Copy the fields into an owning nbtserver
+	nbtserver to_server() const;
+
+private:
+	const server_index* index;
+	std::size_t i;
+};
+
+// The entries of a servers.dat as lazy server_views, for tools that only
+// look at a few fields. Opening costs one structural scan (or loading the
+// sidecar index), never a copy of the strings. The index lives on the heap,
+// so views and iterators survive the list being moved; they must not
+// outlive it, or a later open().
+class server_list_view {
+public:
+	class iterator {
+	public:
+		iterator(const server_index& index, std::size_t i) : index(&index), i(i) {}
+		server_view operator*() const { return server_view(*index, i); }
+		iterator& operator++() { ++i; return *this; }
+		bool operator==(const iterator& other) const { return i == other.i; }
+
+	private:
+		const server_index* index;
+		std::size_t i;
+	};
+
+	server_list_view() : index(std::make_unique<server_index>()) {}
+
+	bool open(const std::string& path, nbt_flavor flavor = nbt_flavor::java, bool persist = false) {
+		return index->open(path, flavor, persist);
+	}
+
+	std::size_t size() const { return index->size(); }
+	server_view operator[](std::size_t i) const { return server_view(*index, i); }
+	iterator begin() const { return iterator(*index, 0); }
+	iterator end() const { return iterator(*index, index->size()); }
+
+private:
+	std::unique_ptr<server_index> index;
+};
+
+#endif
@@ -0,0 +1,128 @@
+//NBTDocument - an in-memory NBT tree for inspecting and editing any file
+//Written for enbt; built on NBTReader's visitor and saved with NBTWriter
+
+#ifndef _NBTDOCUMENT_H
+#define _NBTDOCUMENT_H
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "NBTReader.h"
+#include "NBTWriter.h"
+
+namespace NBT{
+
+//Bump allocator: hands out memory from large blocks and frees it all at
+//once, so a tree of small nodes costs no per-node allocation or destructor
+class Arena
+{
+	private:
+		std::vector<std::unique_ptr<char[]>> Blocks;
+		char*Next;
+		size_t Left;
+		size_t BlockSize;
+
+	public:
+		explicit Arena(size_t blockSize=65536);
+		Arena(const Arena&)=delete;
+		Arena&operator=(const Arena&)=delete;
+		//The blocks move with their contents; the source is left empty
+		Arena(Arena&&other) noexcept;
+		Arena&operator=(Arena&&other) noexcept;
+
+		void*allocate(size_t size,size_t align);
+		template<typename T>
+		T*allocateArray(size_t count)
+		{
+			return static_cast<T*>(allocate(count*sizeof(T),alignof(T)));
+		}
+		//NUL-terminated copy, so data() can be handed to NBTWriter
+		std::string_view copyString(std::string_view text);
+		//Release everything; earlier pointers become invalid
+		void clear();
+};
+
+//One tag. Scalars are stored inline; names, strings, array elements and the
+//children of compounds and lists live in the owning Document's arena
+struct Node
+{
+	//Empty for list elements and the root
+	std::string_view name;
+	//String text, array elements in host order, or the Node children
+	void*data;
+	union
+	{
+		//Byte, Short, Int, Long
+		long long integer;
+		//Float, Double
+		double real;
+	};
+	//String length, array length or number of children
+	int count;
+	char type;
+	//Element type of a list
+	char elementType;
+
+	//Children of a compound or list, stored contiguously
+	std::span<Node> children();
+	std::span<const Node> children() const;
+	//First child of a compound with that name, or nullptr
+	Node*find(std::string_view childName);
+	const Node*find(std::string_view childName) const;
+
+	std::string_view string() const;
+	std::span<const char> byteArray() const;
+	std::span<const int> intArray() const;
+	std::span<const long long> longArray() const;
+};
+
+//A whole NBT file as a tree. root() is the unnamed root compound
+class Document
+{
+	private:
+		Arena Memory;
+		Node Root;
+
+		template<std::endian Order>
+		Result<void> loadFrom(BasicNBTReader<Order>&reader);
+		template<std::endian Order>
+		bool saveTo(BasicNBTWriter<Order>&writer) const;
+
+	public:
+		Document();
+
+		//Read the rest of reader's current compound, which for a freshly
+		//opened reader is the whole file. On error the document is empty
+		Result<void> load(NBTReader&reader);
+		Result<void> load(NBTReaderLE&reader);
+		//Write the root's children; the caller closes the writer. Returns
+		//false, with the output incomplete, if a string can't be written
+		//because it is longer than 65535 bytes
+		bool save(NBTWriter&writer) const;
+		bool save(NBTWriterLE&writer) const;
+
+		Node&root();
+		const Node&root() const;
+		//Drop the whole tree and its arena in one go
+		void clear();
+
+		//Editing. Old storage is not reclaimed until clear() or destruction
+		//Returns false and leaves node as it was if text is over 65535 bytes
+		bool setString(Node&node,std::string_view text);
+		//Add a child to a compound (named) or list (name ignored) and return
+		//it. The first child of a list sets its element type; later ones of
+		//another type, and TAG_End values, are refused with nullptr. The
+		//container's children move, so earlier child pointers go stale; set
+		//a string child's text with setString
+		Node*append(Node&container,std::string_view name,const Node&value);
+};
+
+//NameSpace NBT ends here
+}
+
+#endif
@@ -0,0 +1,125 @@
+//NBTGzip - streaming gzip inflate/deflate for compressed NBT files
+//Written for enbt; no zlib dependency
+
+#ifndef _NBTGZIP_H
+#define _NBTGZIP_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace NBT{
+
+//True if data starts with the gzip magic bytes 1f 8b
+bool isGzip(const char*data,size_t length);
+
+//CRC-32 as used by gzip; pass the previous result to continue a checksum
+std::uint32_t crc32(std::uint32_t crc,const char*data,size_t length);
+
+//Decompresses a gzip stream whose compressed bytes are all in memory (a
+//mapped file or a caller's buffer). Output is produced in pieces of the
+//caller's choosing, so only the 32K history window is kept between calls.
+class Inflater
+{
+	private:
+		static constexpr int FastBits=9;
+		struct HuffmanTable
+		{
+			short Count[16];
+			short Symbol[288];
+			//Codes of at most FastBits bits: symbol<<4|length, 0 if longer
+			unsigned short Fast[1<<FastBits];
+		};
+		enum class Stage:unsigned char{Member,BlockHeader,Stored,Huffman,Trailer,Done,Failed};
+
+		const unsigned char*In;
+		const unsigned char*InEnd;
+		std::uint64_t Bits;
+		int BitCount;
+		Stage State;
+		bool LastBlock;
+		bool AnyMember;
+		size_t StoredLeft;
+		int CopyLength;
+		int CopyDistance;
+		std::vector<unsigned char> Window;
+		size_t WindowPos;
+		std::uint64_t Produced;
+		std::uint32_t Crc;
+		HuffmanTable LitLen;
+		HuffmanTable Dist;
+		const char*Message;
+
+		bool need(int n);
+		unsigned take(int n);
+		bool fail(const char*message);
+		bool buildTable(HuffmanTable&table,const unsigned char*lengths,int count);
+		int decode(const HuffmanTable&table);
+		bool readMemberHeader();
+		bool readBlockHeader();
+		bool readDynamicTables();
+		bool readTrailer();
+
+	public:
+		Inflater(const char*data,size_t length);
+		//Fill out with up to capacity bytes; returns fewer only at the end
+		//of the stream or on an error (see failed())
+		size_t read(char*out,size_t capacity);
+		bool failed() const {return State==Stage::Failed;}
+		bool finished() const {return State==Stage::Done;}
+		const char*errorMessage() const {return Message;}
+};
+
+//Compresses into a gzip stream incrementally. level 0 stores, 1-9 trade
+//speed for size like zlib's levels.
+class Deflater
+{
+	private:
+		struct Token
+		{
+			unsigned short LitOrLength;
+			//0 for a literal
+			unsigned short Distance;
+		};
+
+		int Level;
+		int MaxChain;
+		int NiceLength;
+		bool Lazy;
+		//32K of history followed by input not yet compressed
+		std::vector<unsigned char> Data;
+		size_t Start;
+		std::vector<int> Head;
+		std::vector<int> Prev;
+		std::vector<Token> Tokens;
+		std::uint64_t Bits;
+		int BitCount;
+		std::uint32_t Crc;
+		std::uint32_t Size;
+		bool HeaderWritten;
+
+		void putBits(std::uint32_t value,int count,std::vector<char>&out);
+		void alignToByte(std::vector<char>&out);
+		int hashAt(size_t pos) const;
+		void insert(size_t pos);
+		int findMatch(size_t pos,size_t end,int*distance) const;
+		void tokenize(size_t end);
+		void writeBlock(size_t end,bool final,std::vector<char>&out);
+		void writeStored(size_t end,bool final,std::vector<char>&out);
+		void compressPending(bool final,std::vector<char>&out);
+		void slide();
+
+	public:
+		explicit Deflater(int level);
+		//Compress data, appending whatever output is ready to out
+		void write(const char*data,size_t length,std::vector<char>&out);
+		//Compress the rest and append the gzip trailer
+		void finish(std::vector<char>&out);
+};
+
+//NameSpace NBT ends here
+}
+
+#endif
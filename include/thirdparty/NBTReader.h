@@ -32,32 +32,143 @@ This file is part of SlopeCraft.
 #include <iostream>
 #include <fstream>
 #include <cstring>
+#include <cstddef>
+#include <expected>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <span>
+#include <vector>
 #include <stdexcept>
 
 #include "NBTWriter.h"
+#include "NBTGzip.h"
 
-#define TwinStackSize 128
+//Deepest compound/list nesting visit() accepts, as in Minecraft
+#define VisitDepthLimit 512
 
 namespace NBT{
 
-class NBTReader
+//Read-only view of a whole file, memory-mapped where the platform allows it
+//and read into a heap buffer otherwise (pipes, procfs, ...)
+class MappedFile
+{
+	private:
+		const char *Data;
+		size_t Length;
+		bool isMapped;
+		std::vector<char> Fallback;
+#ifdef _WIN32
+		void *FileHandle;
+		void *MapHandle;
+#endif
+		void release();
+
+	public:
+		MappedFile();
+		explicit MappedFile(const char*path);
+		~MappedFile();
+		MappedFile(MappedFile&&other) noexcept;
+		MappedFile&operator=(MappedFile&&other) noexcept;
+		MappedFile(const MappedFile&)=delete;
+		MappedFile&operator=(const MappedFile&)=delete;
+
+		bool open(const char*path);
+		void close();
+		const char*data() const {return Data;}
+		size_t size() const {return Length;}
+};
+
+//Non-throwing API: every tryX() returns Result<T> instead of throwing
+enum class ErrorCode : unsigned char
+{
+	OpenFailed,
+	BadHeader,
+	NotOpen,
+	UnexpectedEof,
+	NegativeLength,
+	UnknownTagType,
+	TypeMismatch,
+	ListTypeMismatch,
+	NameMismatch,
+	NotInCompound,
+	MissingEnd,
+	ArrayOverrun,
+	CorruptCompression,
+	TooDeep,
+	NotSeekable
+};
+
+struct Error
+{
+	ErrorCode code;
+	//Bytes consumed when the error was detected
+	unsigned long long offset;
+	//TypeMismatch: the type that was asked for
+	char expectedType;
+	//NameMismatch: both names. CorruptCompression: the inflater's reason
+	//in actualName. Copies, so the error can outlive the reader
+	std::string expectedName;
+	std::string actualName;
+
+	std::string message() const;
+};
+
+template<typename T>
+using Result=std::expected<T,Error>;
+
+//A tag value reported to a Visitor; only the member for type is set
+struct TagValue
+{
+	char type;
+	//Byte, Short, Int, Long
+	long long integer;
+	//Float, Double
+	double real;
+	//String: the text. Byte/Int/LongArray: the raw payload in file byte order
+	std::string_view bytes;
+	//Array element count
+	int count;
+};
+
+//Push-style parsing: visit() walks the data and calls these for each tag.
+//Names are empty for list elements. Views are only valid during the call.
+//Returning false from a Begin callback skips that container's contents.
+class Visitor
+{
+	public:
+		virtual ~Visitor()=default;
+		virtual bool onCompoundBegin(std::string_view){return true;}
+		virtual void onCompoundEnd(){}
+		virtual bool onListBegin(std::string_view,char,int){return true;}
+		virtual void onListEnd(){}
+		virtual void onTag(std::string_view,const TagValue&){}
+};
+
+//Order is the byte order of the NBT data, as for BasicNBTWriter
+template<std::endian Order>
+class BasicNBTReader
 {
 	private:
 		//Vars
+		static constexpr bool NeedsSwap=Order!=std::endian::native;
 		bool isOpen;
-		bool isBE;
-        std::ifstream *File;
-		unsigned long long ByteCount;
-		short top;
-		char CLA[TwinStackSize];
-		int Size[TwinStackSize];
+		MappedFile Mapping;
+		//Decoding advances Cursor through [Begin,End)
+		const char *Begin;
+		const char *Cursor;
+		const char *End;
+		//gzip input: Begin..End is a window of inflated bytes refilled by
+		//require(), and StreamBase is the inflated offset of Begin
+		std::unique_ptr<Inflater> Inflate;
+		std::vector<char> Stream;
+		unsigned long long StreamBase;
+		TwinStack Stack;
 
 		//StackFun
 		void pop();
 		void push(char typeId,int size);
 		bool isEmpty();
-		bool isFull();
 		char readType();
 		int readSize();
 
@@ -67,18 +178,35 @@ class NBTReader
 		bool typeMatch(char typeId);
 
 		//Low-level reading
+		std::unexpected<Error> fail(ErrorCode code,char expectedType=idEnd);
+		Result<void> require(size_t n);
+		Result<void> refill(size_t n);
+		Result<void> advance(long long n);
+		Result<void> copyOut(char*out,size_t n);
+		Result<void> startInput(const char*data,size_t length);
+		Result<void> skipListElements(char elementType,int count);
+		Result<void> readHeader();
+
+		template<typename T>
+		Result<T> readValue();
 		template<typename T>
-		T readValue();
+		Result<T> tryReadSingle(char typeId,const char*expectedName);
+		Result<int> tryReadArrayHead(char arrayType,char elementType,const char*expectedName);
+		Result<void> tryReadArrayPayload(char elementType,void*out,size_t count,size_t width);
 
-		short readNameLength();
-		std::string readName(short length);
+		Result<unsigned short> readLength16();
+		Result<void> matchTagHeader(char typeId,const char*expectedName);
 
 	public:
 		//Construct&deConstruct
-		NBTReader(const char*path);
-		~NBTReader();
-        NBTReader();
+		BasicNBTReader(const char*path);
+		//Reads from caller-owned memory, which must outlive the reader
+		explicit BasicNBTReader(std::span<const std::byte> data);
+		~BasicNBTReader();
+        BasicNBTReader();
         void open(const char*path);
+		Result<void> tryOpen(const char*path);
+		Result<void> tryOpen(std::span<const std::byte> data);
 
 		//Vars
 
@@ -93,17 +221,50 @@ class NBTReader
 		char peekTagType();
 		char readTagType();
 		std::string readTagName();
+		//Views stay valid until the reader is closed; for gzip input only
+		//until the next read
+		std::string_view readTagNameView();
+		Result<char> tryPeekTagType();
+		Result<char> tryReadTagType();
+		Result<std::string_view> tryReadTagNameView();
+
+		//Payload readers for use after readTagType/readTagNameView
+		char readBytePayload();
+		std::string_view readStringPayloadView();
+		Result<char> tryReadBytePayload();
+		Result<std::string_view> tryReadStringPayloadView();
+
+		//Report the rest of the current compound to visitor and consume its
+		//TAG_End, as exitCompound would. From a fresh reader: the whole file
+		void visit(Visitor&visitor);
+		Result<void> tryVisit(Visitor&visitor);
+		//Check the structure of the rest of the current compound without
+		//decoding it: type bytes, lengths, bounds and nesting within
+		//VisitDepthLimit. The error's offset is the first bad byte
+		void validate();
+		Result<void> tryValidate();
+
+		//Jump to the payload of a compound at offset (a getByteCount() value)
+		//and make it the only open one: read its tags, then exitCompound().
+		//Raw input only, since gzip input can't be entered mid-stream
+		void seekCompound(unsigned long long offset);
+		Result<void> trySeekCompound(unsigned long long offset);
 
 		//Skip operations
 		void skipTag(char tagType);
 		void skipCurrentTag();
+		Result<void> trySkipTag(char tagType);
+		Result<void> trySkipCurrentTag();
 
 		//Read compound tags
 		void enterCompound(const char*expectedName = nullptr);
 		void exitCompound();
+		Result<void> tryEnterCompound(const char*expectedName = nullptr);
+		Result<void> tryExitCompound();
 
 		//Read list tags
 		void readListHead(const char*expectedName, char* outElementType, int* outSize);
+		Result<void> tryReadListHead(const char*expectedName, char* outElementType, int* outSize);
 
 		//ReadRealSingleTags
 		char readByte(const char*expectedName = nullptr);
@@ -113,15 +274,40 @@ class NBTReader
 		float readFloat(const char*expectedName = nullptr);
 		double readDouble(const char*expectedName = nullptr);
 		std::string readString(const char*expectedName = nullptr);
+		std::string_view readStringView(const char*expectedName = nullptr);
+		Result<char> tryReadByte(const char*expectedName = nullptr);
+		Result<short> tryReadShort(const char*expectedName = nullptr);
+		Result<int> tryReadInt(const char*expectedName = nullptr);
+		Result<long long> tryReadLong(const char*expectedName = nullptr);
+		Result<float> tryReadFloat(const char*expectedName = nullptr);
+		Result<double> tryReadDouble(const char*expectedName = nullptr);
+		Result<std::string_view> tryReadStringView(const char*expectedName = nullptr);
 
 		//ReadArrayHeads
 		int readLongArrayHead(const char*expectedName = nullptr);
 		int readByteArrayHead(const char*expectedName = nullptr);
 		int readIntArrayHead(const char*expectedName = nullptr);
+		Result<int> tryReadLongArrayHead(const char*expectedName = nullptr);
+		Result<int> tryReadByteArrayHead(const char*expectedName = nullptr);
+		Result<int> tryReadIntArrayHead(const char*expectedName = nullptr);
+
+		//ReadArrayPayloads: after an array or list head, fill out with the
+		//next out.size() elements in one copy
+		void readByteArray(std::span<char> out);
+		void readIntArray(std::span<int> out);
+		void readLongArray(std::span<long long> out);
+		Result<void> tryReadByteArray(std::span<char> out);
+		Result<void> tryReadIntArray(std::span<int> out);
+		Result<void> tryReadLongArray(std::span<long long> out);
 
         unsigned long long getByteCount();
 };
 
+using NBTReader=BasicNBTReader<std::endian::big>;
+using NBTReaderLE=BasicNBTReader<std::endian::little>;
+extern template class BasicNBTReader<std::endian::big>;
+extern template class BasicNBTReader<std::endian::little>;
+
 
 
 //NameSpace NBT ends here
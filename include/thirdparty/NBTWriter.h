@@ -32,8 +32,19 @@ This file is part of SlopeCraft.
 #include <iostream>
 #include <fstream>
 #include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <bit>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <memory>
+#include "NBTGzip.h"
 //using namespace std;
-#define TwinStackSize 128
+//Nesting levels TwinStack holds inline before moving to the heap
+#define TwinStackSize 16
+#define WriterBlockSize 65536
 namespace NBT{
 	const char idEnd=0;
 	const char idByte=1;
@@ -49,43 +60,95 @@ namespace NBT{
 	const char idIntArray=11;
 	const char idLongArray=12;
 
+    //Reverse the bytes of any 1, 2, 4 or 8 byte value; compiles to bswap
     template <typename T>
-    void IE2BE(T &Val) {
-        if (sizeof(T)<=1)return;
-        char *s=(char*)&Val;
-        for(short i=0;i*2+1<(signed)sizeof(T);i++)
-        std::swap(s[i],s[sizeof(T)-1-i]);
+    constexpr T byteSwap(T Val) {
+        if constexpr (sizeof(T)==1) return Val;
+        else if constexpr (std::is_integral_v<T>) return std::byteswap(Val);
+        else if constexpr (sizeof(T)==4) return std::bit_cast<T>(std::byteswap(std::bit_cast<std::uint32_t>(Val)));
+        else return std::bit_cast<T>(std::byteswap(std::bit_cast<std::uint64_t>(Val)));
     }
 
     template <typename T>
-    T IE2BE(T *Val) {
-        if (sizeof(T)<=1)return *Val;
-
-        T Res=*Val;
-        char *s=(char*)&Res;
-        for(short i=0;i*2+1<(signed)sizeof(T);i++)
-        std::swap(s[i],s[sizeof(T)-1-i]);
-        return Res;
+    constexpr void IE2BE(T &Val) {
+        Val=byteSwap(Val);
     }
 
-    bool isSysBE();
+    template <typename T>
+    constexpr T IE2BE(T *Val) {
+        return byteSwap(*Val);
+    }
+
+    //Byte-swap count elements of width 2, 4 or 8 bytes in place;
+    //uses SSSE3 shuffles when the CPU has them
+    void IE2BEArray(void*data,size_t count,size_t width);
 
-class NBTWriter
+    constexpr bool isSysBE() {
+        return std::endian::native==std::endian::big;
+    }
+
+    //The open lists and compounds of a reader or writer: the element type
+    //(idEnd for a compound) and the elements left at each level. Starts in
+    //an inline buffer and doubles on the heap for deeper data, so push
+    //never drops a level and construction touches nothing but three fields
+    class TwinStack
+    {
+        private:
+            struct Level
+            {
+                int Size;
+                char Type;
+            };
+            Level Inline[TwinStackSize];
+            std::unique_ptr<Level[]> Heap;
+            Level *Levels;
+            int Capacity;
+            int Top;
+            void grow();
+
+        public:
+            TwinStack():Levels(Inline),Capacity(TwinStackSize),Top(-1){}
+            TwinStack(const TwinStack&other);
+            TwinStack&operator=(const TwinStack&other);
+
+            bool empty() const {return Top<0;}
+            int depth() const {return Top+1;}
+            void push(char typeId,int size)
+            {
+                if(Top+1==Capacity)grow();
+                Top++;
+                Levels[Top].Type=typeId;
+                Levels[Top].Size=size;
+            }
+            void pop() {if(Top>=0)Top--;}
+            void clear() {Top=-1;}
+            char type() const {return Levels[Top].Type;}
+            int&size() {return Levels[Top].Size;}
+    };
+
+//Order is the byte order of the NBT data; it is fixed at compile time
+//so values are swapped only when it differs from the host
+template<std::endian Order>
+class BasicNBTWriter
 {
 	private:
 		//Vars
+		static constexpr bool NeedsSwap=Order!=std::endian::native;
 		bool isOpen;
-		bool isBE;
         std::fstream *File;
+		std::vector<std::byte> *Sink;
+		std::vector<char> Buffer;
 		unsigned long long ByteCount;
-		short top;
-		char CLA[TwinStackSize];
-		int Size[TwinStackSize];
+		//Where the Bedrock header starts in the output, or -1 if none
+		long long HeaderAt;
+		//Set by setCompression; blocks are deflated into Packed on flush
+		std::unique_ptr<Deflater> Compressor;
+		std::vector<char> Packed;
+		TwinStack Stack;
 		//StackFun
 		void pop();
 		void push(char typeId,int size);
 		bool isEmpty();
-		bool isFull();
 		char readType();
 		char readSize();
 		//WriterFun
@@ -95,12 +158,24 @@ class NBTWriter
 		bool typeMatch(char typeId);
 		//AutoFiller
 		int emergencyFill();
+		//Buffered output
+		void put(const char*data,size_t length);
+		int putArrayPayload(const void*data,size_t count,size_t width);
+		void patchBedrockHeader();
+		void emit(const char*data,size_t length);
 	public:
 		//Construct&deConstruct
-		NBTWriter(const char*path);
-		~NBTWriter();
-        NBTWriter();
+		BasicNBTWriter(const char*path);
+		//Appends the NBT bytes to sink instead of writing a file
+		explicit BasicNBTWriter(std::vector<std::byte>&sink);
+		~BasicNBTWriter();
+        BasicNBTWriter();
         void open(const char*path);
+		//Prefix the level.dat header Bedrock expects; call before any tag
+		void writeBedrockHeader(int storageVersion);
+		//gzip the output at level 0-9; call before any tag. Not combined
+		//with writeBedrockHeader, whose length must be patched in place
+		void setCompression(int level);
 		//Vars
 		bool allowEmergencyFill;
 		//WriterFun
@@ -111,6 +186,7 @@ class NBTWriter
 		bool isInList();
 		bool isInCompound();
 		unsigned long long close();
+		void flush();
 		bool isListFinished();
 		char CurrentType();
 		//WriteAbstractTags
@@ -123,6 +199,9 @@ class NBTWriter
 		int writeListHead(const char*Name,char typeId,int listSize);
 		int endCompound();
 		int writeString(const char*Name,const char*value);
+		//Writes value's exact bytes, embedded NULs included. Returns 0 and
+		//writes nothing if it is longer than the 65535 bytes NBT allows
+		int writeString(const char*Name,std::string_view value);
 		//WriteRealSingleTags
 		int writeByte(const char*Name,char value);
 		int writeShort(const char*Name,short value);
@@ -134,9 +213,19 @@ class NBTWriter
 		int writeLongArrayHead(const char*Name,int arraySize);
 		int writeByteArrayHead(const char*Name,int arraySize);
 		int writeIntArrayHead(const char*Name,int arraySize);
+		//WriteWholeArrays: head and payload in one call
+		int writeByteArray(const char*Name,std::span<const char> values);
+		int writeIntArray(const char*Name,std::span<const int> values);
+		int writeLongArray(const char*Name,std::span<const long long> values);
         unsigned long long getByteCount();
 };
 
+//Java Edition NBT is big-endian, Bedrock Edition little-endian
+using NBTWriter=BasicNBTWriter<std::endian::big>;
+using NBTWriterLE=BasicNBTWriter<std::endian::little>;
+extern template class BasicNBTWriter<std::endian::big>;
+extern template class BasicNBTWriter<std::endian::little>;
+
 
 
 //NameSpace NBT ends here
@@ -0,0 +1,359 @@
+//NBTDocument - an in-memory NBT tree for inspecting and editing any file
+//Nodes, names and strings are bump-allocated; children are contiguous
+
+#ifndef _NBTDocument_Cpp
+#define _NBTDocument_Cpp
+#include "NBTDocument.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+using namespace NBT;
+
+Arena::Arena(size_t blockSize)
+    :Next(nullptr),Left(0),BlockSize(blockSize)
+{
+}
+
+Arena::Arena(Arena&&other) noexcept
+    :Blocks(std::move(other.Blocks)),Next(other.Next),Left(other.Left),BlockSize(other.BlockSize)
+{
+    other.Next=nullptr;other.Left=0;
+}
+
+Arena&Arena::operator=(Arena&&other) noexcept
+{
+    if(this==&other)return *this;
+    Blocks=std::move(other.Blocks);
+    Next=other.Next;Left=other.Left;BlockSize=other.BlockSize;
+    other.Blocks.clear();
+    other.Next=nullptr;other.Left=0;
+    return *this;
+}
+
+void*Arena::allocate(size_t size,size_t align)
+{
+    size_t pad=(align-reinterpret_cast<std::uintptr_t>(Next)%align)%align;
+    if(size+pad<=Left)
+    {
+        char*result=Next+pad;
+        Next+=pad+size;Left-=pad+size;
+        return result;
+    }
+    // Big requests get a block of their own so the current one keeps going
+    if(size>BlockSize/4)
+    {
+        Blocks.emplace_back(new char[size+align]);
+        char*raw=Blocks.back().get();
+        return raw+(align-reinterpret_cast<std::uintptr_t>(raw)%align)%align;
+    }
+    Blocks.emplace_back(new char[BlockSize]);
+    Next=Blocks.back().get();Left=BlockSize;
+    return allocate(size,align);
+}
+
+std::string_view Arena::copyString(std::string_view text)
+{
+    if(text.empty())return std::string_view("",0);
+    char*copy=allocateArray<char>(text.size()+1);
+    std::memcpy(copy,text.data(),text.size());
+    copy[text.size()]='\0';
+    return std::string_view(copy,text.size());
+}
+
+void Arena::clear()
+{
+    Blocks.clear();
+    Next=nullptr;Left=0;
+}
+
+std::span<Node> Node::children()
+{
+    if(type!=idCompound&&type!=idList)return {};
+    return std::span<Node>(static_cast<Node*>(data),count);
+}
+
+std::span<const Node> Node::children() const
+{
+    if(type!=idCompound&&type!=idList)return {};
+    return std::span<const Node>(static_cast<const Node*>(data),count);
+}
+
+Node*Node::find(std::string_view childName)
+{
+    if(type!=idCompound)return nullptr;
+    for(Node&child:children())
+        if(child.name==childName)return &child;
+    return nullptr;
+}
+
+const Node*Node::find(std::string_view childName) const
+{
+    return const_cast<Node*>(this)->find(childName);
+}
+
+std::string_view Node::string() const
+{
+    if(type!=idString)return {};
+    return std::string_view(static_cast<const char*>(data),count);
+}
+
+std::span<const char> Node::byteArray() const
+{
+    if(type!=idByteArray)return {};
+    return std::span<const char>(static_cast<const char*>(data),count);
+}
+
+std::span<const int> Node::intArray() const
+{
+    if(type!=idIntArray)return {};
+    return std::span<const int>(static_cast<const int*>(data),count);
+}
+
+std::span<const long long> Node::longArray() const
+{
+    if(type!=idLongArray)return {};
+    return std::span<const long long>(static_cast<const long long*>(data),count);
+}
+
+static Node emptyCompound()
+{
+    Node node{};
+    node.name=std::string_view("",0);
+    node.type=idCompound;
+    node.elementType=idEnd;
+    return node;
+}
+
+// Collects each container's children on one scratch stack and moves them
+// into a single arena array when the container closes
+class DocumentBuilder:public Visitor
+{
+    private:
+        Arena&Memory;
+        bool Swap;
+        std::vector<Node> Pending;
+        //Index in Pending of each open container
+        std::vector<size_t> Open;
+
+        void open(std::string_view name,char type,char elementType)
+        {
+            Node node{};
+            node.name=Memory.copyString(name);
+            node.type=type;node.elementType=elementType;
+            Open.push_back(Pending.size());
+            Pending.push_back(node);
+        }
+
+    public:
+        DocumentBuilder(Arena&memory,bool swap):Memory(memory),Swap(swap)
+        {
+            Pending.reserve(256);
+            Open.reserve(16);
+            Open.push_back(0);
+            Pending.push_back(emptyCompound());
+        }
+
+        void close()
+        {
+            size_t at=Open.back();Open.pop_back();
+            size_t count=Pending.size()-at-1;
+            Node*children=Memory.allocateArray<Node>(count);
+            std::copy(Pending.begin()+at+1,Pending.end(),children);
+            Pending[at].data=children;
+            Pending[at].count=static_cast<int>(count);
+            Pending.resize(at+1);
+        }
+
+        Node root() const {return Pending.front();}
+
+        bool onCompoundBegin(std::string_view name) override
+        {
+            open(name,idCompound,idEnd);
+            return true;
+        }
+        void onCompoundEnd() override {close();}
+        bool onListBegin(std::string_view name,char elementType,int) override
+        {
+            open(name,idList,elementType);
+            return true;
+        }
+        void onListEnd() override {close();}
+
+        void onTag(std::string_view name,const TagValue&value) override
+        {
+            Node node{};
+            node.name=Memory.copyString(name);
+            node.type=value.type;
+            switch(value.type)
+            {
+                case idFloat:
+                case idDouble:
+                    node.real=value.real;
+                    break;
+                case idString:
+                {
+                    std::string_view text=Memory.copyString(value.bytes);
+                    node.data=const_cast<char*>(text.data());
+                    node.count=static_cast<int>(text.size());
+                    break;
+                }
+                case idByteArray:
+                case idIntArray:
+                case idLongArray:
+                {
+                    size_t width=value.type==idByteArray?1:value.type==idIntArray?4:8;
+                    void*elements=Memory.allocate(value.bytes.size(),width);
+                    std::memcpy(elements,value.bytes.data(),value.bytes.size());
+                    if(Swap)IE2BEArray(elements,value.count,width);
+                    node.data=elements;
+                    node.count=value.count;
+                    break;
+                }
+                default:
+                    node.integer=value.integer;
+                    break;
+            }
+            Pending.push_back(node);
+        }
+};
+
+Document::Document()
+    :Root(emptyCompound())
+{
+}
+
+template<std::endian Order>
+Result<void> Document::loadFrom(BasicNBTReader<Order>&reader)
+{
+    clear();
+    DocumentBuilder builder(Memory,Order!=std::endian::native);
+    if(auto ok=reader.tryVisit(builder);!ok)
+    {
+        clear();
+        return ok;
+    }
+    builder.close();
+    Root=builder.root();
+    return {};
+}
+
+Result<void> Document::load(NBTReader&reader)
+{
+    return loadFrom(reader);
+}
+
+Result<void> Document::load(NBTReaderLE&reader)
+{
+    return loadFrom(reader);
+}
+
+// Walks the tree with an explicit stack, like the reader's visit()
+template<std::endian Order>
+bool Document::saveTo(BasicNBTWriter<Order>&writer) const
+{
+    struct Frame
+    {
+        const Node*next;
+        const Node*end;
+        bool isCompound;
+    };
+    std::vector<Frame> frames;
+    frames.push_back({Root.children().data(),Root.children().data()+Root.count,true});
+    while(!frames.empty())
+    {
+        Frame&frame=frames.back();
+        if(frame.next==frame.end)
+        {
+            bool isCompound=frame.isCompound;
+            frames.pop_back();
+            if(isCompound&&!frames.empty())writer.endCompound();
+            continue;
+        }
+        const Node&node=*frame.next++;
+        const char*name=node.name.data();
+        switch(node.type)
+        {
+            case idByte:writer.writeByte(name,static_cast<char>(node.integer));break;
+            case idShort:writer.writeShort(name,static_cast<short>(node.integer));break;
+            case idInt:writer.writeInt(name,static_cast<int>(node.integer));break;
+            case idLong:writer.writeLong(name,node.integer);break;
+            case idFloat:writer.writeFloat(name,static_cast<float>(node.real));break;
+            case idDouble:writer.writeDouble(name,node.real);break;
+            case idString:
+                if(writer.writeString(name,node.string())==0)return false;
+                break;
+            case idByteArray:writer.writeByteArray(name,node.byteArray());break;
+            case idIntArray:writer.writeIntArray(name,node.intArray());break;
+            case idLongArray:writer.writeLongArray(name,node.longArray());break;
+            case idCompound:
+                writer.writeCompound(name);
+                frames.push_back({node.children().data(),node.children().data()+node.count,true});
+                break;
+            case idList:
+                writer.writeListHead(name,node.elementType,node.count);
+                frames.push_back({node.children().data(),node.children().data()+node.count,false});
+                break;
+        }
+    }
+    return true;
+}
+
+bool Document::save(NBTWriter&writer) const
+{
+    return saveTo(writer);
+}
+
+bool Document::save(NBTWriterLE&writer) const
+{
+    return saveTo(writer);
+}
+
+Node&Document::root()
+{
+    return Root;
+}
+
+const Node&Document::root() const
+{
+    return Root;
+}
+
+void Document::clear()
+{
+    Memory.clear();
+    Root=emptyCompound();
+}
+
+bool Document::setString(Node&node,std::string_view text)
+{
+    if(text.size()>0xFFFF)return false;
+    std::string_view copy=Memory.copyString(text);
+    node.type=idString;
+    node.data=const_cast<char*>(copy.data());
+    node.count=static_cast<int>(copy.size());
+    return true;
+}
+
+Node*Document::append(Node&container,std::string_view name,const Node&value)
+{
+    if(value.type==idEnd)return nullptr;
+    if(container.type==idList)
+    {
+        if(container.count==0)container.elementType=value.type;
+        else if(value.type!=container.elementType)return nullptr;
+    }
+    else if(container.type!=idCompound)return nullptr;
+    std::span<Node> old=container.children();
+    Node*children=Memory.allocateArray<Node>(old.size()+1);
+    std::copy(old.begin(),old.end(),children);
+    Node&added=children[old.size()];
+    added=value;
+    added.name=container.type==idCompound?Memory.copyString(name):std::string_view("",0);
+    container.data=children;
+    container.count=static_cast<int>(old.size()+1);
+    return &added;
+}
+
+#endif
@@ -0,0 +1,831 @@
+//NBTGzip - streaming gzip inflate/deflate for compressed NBT files
+//Implements RFC 1951 (deflate) and RFC 1952 (gzip)
+
+#ifndef _NBTGzip_Cpp
+#define _NBTGzip_Cpp
+#include "NBTGzip.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <queue>
+
+using namespace NBT;
+
+static constexpr size_t WindowSize=32768;
+static constexpr size_t WindowMask=WindowSize-1;
+// Input per deflate block; also the largest stored block
+static constexpr size_t BlockSize=65535;
+
+static constexpr unsigned short LengthBase[29]={
+    3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258};
+static constexpr unsigned char LengthExtra[29]={
+    0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0};
+static constexpr unsigned short DistanceBase[30]={
+    1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,
+    1025,1537,2049,3073,4097,6145,8193,12289,16385,24577};
+static constexpr unsigned char DistanceExtra[30]={
+    0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13};
+// Order the code length code lengths are stored in
+static constexpr unsigned char CodeLengthOrder[19]={
+    16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15};
+
+static constexpr std::array<std::uint32_t,256> CrcTable=[]{
+    std::array<std::uint32_t,256> table{};
+    for(std::uint32_t n=0;n<256;n++)
+    {
+        std::uint32_t c=n;
+        for(int k=0;k<8;k++)c=(c&1)?0xEDB88320u^(c>>1):c>>1;
+        table[n]=c;
+    }
+    return table;
+}();
+
+std::uint32_t NBT::crc32(std::uint32_t crc,const char*data,size_t length)
+{
+    crc=~crc;
+    for(size_t i=0;i<length;i++)
+        crc=CrcTable[(crc^static_cast<unsigned char>(data[i]))&0xFF]^(crc>>8);
+    return ~crc;
+}
+
+bool NBT::isGzip(const char*data,size_t length)
+{
+    return length>=2&&static_cast<unsigned char>(data[0])==0x1F&&static_cast<unsigned char>(data[1])==0x8B;
+}
+
+// Fixed Huffman code lengths (RFC 1951 3.2.6)
+static void fixedLengths(unsigned char*litLen,unsigned char*dist)
+{
+    for(int i=0;i<288;i++)litLen[i]=i<144?8:i<256?9:i<280?7:8;
+    for(int i=0;i<30;i++)dist[i]=5;
+}
+
+// Deflate codes are sent most significant bit first into an LSB-first stream
+static unsigned reverseBits(unsigned code,int length)
+{
+    unsigned result=0;
+    for(int i=0;i<length;i++){result=(result<<1)|(code&1);code>>=1;}
+    return result;
+}
+
+// Canonical codes for the given lengths (RFC 1951 3.2.2), already reversed
+static void canonicalCodes(const unsigned char*lengths,int count,unsigned short*codes)
+{
+    int lengthCount[16]={0};
+    for(int i=0;i<count;i++)lengthCount[lengths[i]]++;
+    lengthCount[0]=0;
+    unsigned next[16]={0};
+    unsigned code=0;
+    for(int bits=1;bits<16;bits++)
+    {
+        code=(code+lengthCount[bits-1])<<1;
+        next[bits]=code;
+    }
+    for(int i=0;i<count;i++)
+        codes[i]=lengths[i]?reverseBits(next[lengths[i]]++,lengths[i]):0;
+}
+
+//////////////////////////////////////////////////////////////////// Inflater
+
+Inflater::Inflater(const char*data,size_t length)
+{
+    In=reinterpret_cast<const unsigned char*>(data);
+    InEnd=In+length;
+    Bits=0;
+    BitCount=0;
+    State=Stage::Member;
+    LastBlock=false;
+    AnyMember=false;
+    StoredLeft=0;
+    CopyLength=0;
+    CopyDistance=0;
+    Window.resize(WindowSize);
+    WindowPos=0;
+    Produced=0;
+    Crc=0;
+    Message=nullptr;
+}
+
+bool Inflater::fail(const char*message)
+{
+    if(State!=Stage::Failed)Message=message;
+    State=Stage::Failed;
+    return false;
+}
+
+// Make sure n bits are buffered; the whole input is in memory, so running
+// out means the stream is truncated
+inline bool Inflater::need(int n)
+{
+    while(BitCount<n)
+    {
+        if(In==InEnd)return false;
+        Bits|=static_cast<std::uint64_t>(*In++)<<BitCount;
+        BitCount+=8;
+    }
+    return true;
+}
+
+inline unsigned Inflater::take(int n)
+{
+    unsigned value=static_cast<unsigned>(Bits&((std::uint64_t{1}<<n)-1));
+    Bits>>=n;
+    BitCount-=n;
+    return value;
+}
+
+bool Inflater::buildTable(HuffmanTable&table,const unsigned char*lengths,int count)
+{
+    std::memset(table.Count,0,sizeof(table.Count));
+    std::memset(table.Fast,0,sizeof(table.Fast));
+    for(int i=0;i<count;i++)table.Count[lengths[i]]++;
+    table.Count[0]=0;
+
+    // Over-subscribed codes are corrupt; incomplete ones are allowed
+    int left=1;
+    for(int bits=1;bits<16;bits++)
+    {
+        left<<=1;
+        left-=table.Count[bits];
+        if(left<0)return false;
+    }
+
+    short offsets[16];
+    offsets[1]=0;
+    for(int bits=1;bits<15;bits++)offsets[bits+1]=offsets[bits]+table.Count[bits];
+    for(int i=0;i<count;i++)
+        if(lengths[i])table.Symbol[offsets[lengths[i]]++]=i;
+
+    unsigned short codes[288];
+    canonicalCodes(lengths,count,codes);
+    for(int i=0;i<count;i++)
+    {
+        int length=lengths[i];
+        if(length==0||length>FastBits)continue;
+        for(unsigned fill=codes[i];fill<(1u<<FastBits);fill+=1u<<length)
+            table.Fast[fill]=static_cast<unsigned short>((i<<4)|length);
+    }
+    return true;
+}
+
+// Decode one symbol; -1 on a bad code or truncated input
+inline int Inflater::decode(const HuffmanTable&table)
+{
+    need(15);
+    unsigned short entry=table.Fast[Bits&((1u<<FastBits)-1)];
+    if(entry!=0&&(entry&15)<=BitCount)
+    {
+        take(entry&15);
+        return entry>>4;
+    }
+
+    // Slow path: walk the canonical code one bit at a time
+    int code=0,first=0,index=0;
+    for(int bits=1;bits<16;bits++)
+    {
+        if(!need(1))return -1;
+        code|=take(1);
+        int count=table.Count[bits];
+        if(code-count<first)return table.Symbol[index+(code-first)];
+        index+=count;
+        first+=count;
+        first<<=1;
+        code<<=1;
+    }
+    return -1;
+}
+
+bool Inflater::readMemberHeader()
+{
+    size_t available=InEnd-In;
+    if(available==0&&AnyMember){State=Stage::Done;return true;}
+    if(!isGzip(reinterpret_cast<const char*>(In),available))
+    {
+        // Trailing bytes after a complete member are ignored, like gzip -d
+        if(AnyMember){State=Stage::Done;return true;}
+        return fail("Not a gzip stream");
+    }
+    if(available<10)return fail("Truncated gzip header");
+    if(In[2]!=8)return fail("Unsupported gzip compression method");
+    unsigned char flags=In[3];
+    const unsigned char*p=In+10;
+    if(flags&4)
+    {
+        if(InEnd-p<2)return fail("Truncated gzip header");
+        size_t extra=p[0]|(p[1]<<8);
+        p+=2;
+        if(static_cast<size_t>(InEnd-p)<extra)return fail("Truncated gzip header");
+        p+=extra;
+    }
+    for(int zeroTerminated:{8,16})
+    {
+        if(!(flags&zeroTerminated))continue;
+        while(p<InEnd&&*p!=0)p++;
+        if(p==InEnd)return fail("Truncated gzip header");
+        p++;
+    }
+    if(flags&2)
+    {
+        if(InEnd-p<2)return fail("Truncated gzip header");
+        p+=2;
+    }
+    In=p;
+    Bits=0;
+    BitCount=0;
+    LastBlock=false;
+    Produced=0;
+    Crc=0;
+    State=Stage::BlockHeader;
+    return true;
+}
+
+bool Inflater::readDynamicTables()
+{
+    if(!need(14))return fail("Truncated deflate stream");
+    int litLenCount=take(5)+257;
+    int distCount=take(5)+1;
+    int codeLengthCount=take(4)+4;
+    if(litLenCount>286||distCount>30)return fail("Bad deflate table sizes");
+
+    unsigned char lengths[320]={0};
+    for(int i=0;i<codeLengthCount;i++)
+    {
+        if(!need(3))return fail("Truncated deflate stream");
+        lengths[CodeLengthOrder[i]]=take(3);
+    }
+    HuffmanTable codeLengths;
+    if(!buildTable(codeLengths,lengths,19))return fail("Bad deflate code lengths");
+
+    std::memset(lengths,0,sizeof(lengths));
+    int total=litLenCount+distCount;
+    for(int i=0;i<total;)
+    {
+        int symbol=decode(codeLengths);
+        if(symbol<0)return fail("Bad deflate code lengths");
+        if(symbol<16){lengths[i++]=symbol;continue;}
+
+        int repeat;
+        unsigned char value=0;
+        if(symbol==16)
+        {
+            if(i==0)return fail("Bad deflate code lengths");
+            value=lengths[i-1];
+            if(!need(2))return fail("Truncated deflate stream");
+            repeat=3+take(2);
+        }
+        else if(symbol==17)
+        {
+            if(!need(3))return fail("Truncated deflate stream");
+            repeat=3+take(3);
+        }
+        else
+        {
+            if(!need(7))return fail("Truncated deflate stream");
+            repeat=11+take(7);
+        }
+        if(i+repeat>total)return fail("Bad deflate code lengths");
+        while(repeat--)lengths[i++]=value;
+    }
+
+    if(lengths[256]==0)return fail("Deflate block has no end code");
+    if(!buildTable(LitLen,lengths,litLenCount)||!buildTable(Dist,lengths+litLenCount,distCount))
+        return fail("Bad deflate code lengths");
+    return true;
+}
+
+bool Inflater::readBlockHeader()
+{
+    if(LastBlock){State=Stage::Trailer;return true;}
+    if(!need(3))return fail("Truncated deflate stream");
+    LastBlock=take(1);
+    switch(take(2))
+    {
+        case 0:
+        {
+            take(BitCount&7);
+            if(!need(32))return fail("Truncated deflate stream");
+            unsigned length=take(16);
+            unsigned complement=take(16);
+            if((length^0xFFFF)!=complement)return fail("Corrupt stored block length");
+            StoredLeft=length;
+            State=Stage::Stored;
+            return true;
+        }
+        case 1:
+        {
+            unsigned char litLen[288],dist[30];
+            fixedLengths(litLen,dist);
+            buildTable(LitLen,litLen,288);
+            buildTable(Dist,dist,30);
+            State=Stage::Huffman;
+            return true;
+        }
+        case 2:
+            if(!readDynamicTables())return false;
+            State=Stage::Huffman;
+            return true;
+        default:
+            return fail("Invalid deflate block type");
+    }
+}
+
+bool Inflater::readTrailer()
+{
+    take(BitCount&7);
+    unsigned char trailer[8];
+    for(int i=0;i<8;i++)
+    {
+        if(!need(8))return fail("Truncated gzip trailer");
+        trailer[i]=take(8);
+    }
+    // Give back whole bytes still buffered so the next member starts there
+    In-=BitCount/8;
+    Bits=0;
+    BitCount=0;
+
+    std::uint32_t storedCrc=trailer[0]|(trailer[1]<<8)|(trailer[2]<<16)|(std::uint32_t(trailer[3])<<24);
+    std::uint32_t storedSize=trailer[4]|(trailer[5]<<8)|(trailer[6]<<16)|(std::uint32_t(trailer[7])<<24);
+    if(storedCrc!=Crc)return fail("gzip CRC mismatch");
+    if(storedSize!=static_cast<std::uint32_t>(Produced))return fail("gzip size mismatch");
+    AnyMember=true;
+    State=Stage::Member;
+    return true;
+}
+
+size_t Inflater::read(char*out,size_t capacity)
+{
+    size_t count=0;
+    // Start of the bytes not yet added to the member's CRC
+    size_t crcFrom=0;
+    const auto emit=[&](unsigned char byte){
+        Window[WindowPos++&WindowMask]=byte;
+        out[count++]=static_cast<char>(byte);
+    };
+
+    while(count<capacity)
+    {
+        switch(State)
+        {
+            case Stage::Member:
+                if(!readMemberHeader())return count;
+                continue;
+            case Stage::BlockHeader:
+                if(!readBlockHeader())return count;
+                continue;
+            case Stage::Stored:
+                while(StoredLeft>0&&count<capacity)
+                {
+                    if(BitCount>=8)emit(take(8));
+                    else if(In<InEnd)emit(*In++);
+                    else {fail("Truncated stored block");return count;}
+                    StoredLeft--;
+                    Produced++;
+                }
+                if(StoredLeft==0)State=Stage::BlockHeader;
+                continue;
+            case Stage::Huffman:
+            {
+                if(CopyLength>0)
+                {
+                    int run=static_cast<int>(std::min<size_t>(CopyLength,capacity-count));
+                    for(int i=0;i<run;i++)emit(Window[(WindowPos-CopyDistance)&WindowMask]);
+                    CopyLength-=run;
+                    Produced+=run;
+                    continue;
+                }
+                int symbol=decode(LitLen);
+                if(symbol<0){fail("Bad deflate code");return count;}
+                if(symbol<256){emit(symbol);Produced++;continue;}
+                if(symbol==256){State=Stage::BlockHeader;continue;}
+
+                symbol-=257;
+                if(symbol>=29){fail("Bad deflate length code");return count;}
+                if(!need(LengthExtra[symbol])){fail("Truncated deflate stream");return count;}
+                int length=LengthBase[symbol]+take(LengthExtra[symbol]);
+                int distSymbol=decode(Dist);
+                if(distSymbol<0||distSymbol>=30){fail("Bad deflate distance code");return count;}
+                if(!need(DistanceExtra[distSymbol])){fail("Truncated deflate stream");return count;}
+                int distance=DistanceBase[distSymbol]+take(DistanceExtra[distSymbol]);
+                if(static_cast<std::uint64_t>(distance)>Produced){fail("Deflate distance too far back");return count;}
+                CopyLength=length;
+                CopyDistance=distance;
+                continue;
+            }
+            case Stage::Trailer:
+                Crc=crc32(Crc,out+crcFrom,count-crcFrom);
+                crcFrom=count;
+                if(!readTrailer())return count;
+                continue;
+            case Stage::Done:
+            case Stage::Failed:
+                return count;
+        }
+    }
+    if(State!=Stage::Failed)Crc=crc32(Crc,out+crcFrom,count-crcFrom);
+    return count;
+}
+
+//////////////////////////////////////////////////////////////////// Deflater
+
+// Length 3..258 to symbol 257..285 with its extra bits
+static void lengthSymbol(int length,int*symbol,int*extraBits,int*extraValue)
+{
+    int x=length-3;
+    if(x<8){*symbol=257+x;*extraBits=0;*extraValue=0;return;}
+    if(x==255){*symbol=285;*extraBits=0;*extraValue=0;return;}
+    int top=std::bit_width(static_cast<unsigned>(x))-1;
+    *symbol=257+4*(top-1)+((x>>(top-2))&3);
+    *extraBits=top-2;
+    *extraValue=x&((1<<(top-2))-1);
+}
+
+// Distance 1..32768 to symbol 0..29 with its extra bits
+static void distanceSymbol(int distance,int*symbol,int*extraBits,int*extraValue)
+{
+    int x=distance-1;
+    if(x<4){*symbol=x;*extraBits=0;*extraValue=0;return;}
+    int top=std::bit_width(static_cast<unsigned>(x))-1;
+    *symbol=2*top+((x>>(top-1))&1);
+    *extraBits=top-1;
+    *extraValue=x&((1<<(top-1))-1);
+}
+
+// Huffman code lengths for freq, no longer than maxBits
+static void huffmanLengths(const unsigned*freq,int count,int maxBits,unsigned char*lengths)
+{
+    std::memset(lengths,0,count);
+    std::vector<int> used;
+    for(int i=0;i<count;i++)if(freq[i])used.push_back(i);
+    if(used.empty())return;
+    if(used.size()==1)
+    {
+        // A one-code set is incomplete, which zlib rejects for some
+        // tables; pair it with an unused symbol instead
+        lengths[used[0]]=1;
+        lengths[used[0]==0?1:0]=1;
+        return;
+    }
+
+    // Build the tree with a min-heap; leaves are 0..n-1, inner nodes follow
+    int n=static_cast<int>(used.size());
+    std::vector<int> parent(2*n-1,-1);
+    using Node=std::pair<unsigned long long,int>;
+    std::priority_queue<Node,std::vector<Node>,std::greater<Node>> heap;
+    for(int i=0;i<n;i++)heap.push({freq[used[i]],i});
+    int next=n;
+    while(heap.size()>1)
+    {
+        Node a=heap.top();heap.pop();
+        Node b=heap.top();heap.pop();
+        parent[a.second]=parent[b.second]=next;
+        heap.push({a.first+b.first,next++});
+    }
+
+    // Count leaves per depth, folding anything deeper than maxBits into maxBits
+    std::vector<int> depth(2*n-1,0);
+    int perLength[64]={0};
+    for(int node=2*n-3;node>=0;node--)depth[node]=depth[parent[node]]+1;
+    for(int i=0;i<n;i++)perLength[std::min(depth[i],maxBits)]++;
+
+    // Restore the Kraft equality by lengthening the shortest codes that can
+    // take it (as miniz does), then hand lengths out by frequency
+    unsigned long long total=0;
+    for(int bits=maxBits;bits>0;bits--)total+=static_cast<unsigned long long>(perLength[bits])<<(maxBits-bits);
+    while(total!=(1ull<<maxBits))
+    {
+        perLength[maxBits]--;
+        for(int bits=maxBits-1;bits>0;bits--)
+        {
+            if(perLength[bits])
+            {
+                perLength[bits]--;
+                perLength[bits+1]+=2;
+                break;
+            }
+        }
+        total--;
+    }
+
+    std::stable_sort(used.begin(),used.end(),[&](int a,int b){return freq[a]>freq[b];});
+    size_t index=0;
+    for(int bits=1;bits<=maxBits;bits++)
+        for(int k=0;k<perLength[bits];k++)lengths[used[index++]]=bits;
+}
+
+Deflater::Deflater(int level)
+{
+    Level=std::clamp(level,0,9);
+    static constexpr int Chains[10]={0,4,8,16,32,64,128,256,1024,4096};
+    static constexpr int Nice[10]={0,8,16,32,64,128,128,258,258,258};
+    MaxChain=Chains[Level];
+    NiceLength=Nice[Level];
+    Lazy=Level>=4;
+    Data.reserve(WindowSize+BlockSize);
+    Start=0;
+    Head.assign(WindowSize,-1);
+    Prev.assign(WindowSize,-1);
+    Bits=0;
+    BitCount=0;
+    Crc=0;
+    Size=0;
+    HeaderWritten=false;
+}
+
+inline void Deflater::putBits(std::uint32_t value,int count,std::vector<char>&out)
+{
+    Bits|=static_cast<std::uint64_t>(value)<<BitCount;
+    BitCount+=count;
+    while(BitCount>=8)
+    {
+        out.push_back(static_cast<char>(Bits&0xFF));
+        Bits>>=8;
+        BitCount-=8;
+    }
+}
+
+void Deflater::alignToByte(std::vector<char>&out)
+{
+    if(BitCount>0)putBits(0,8-BitCount,out);
+}
+
+inline int Deflater::hashAt(size_t pos) const
+{
+    return ((Data[pos]<<10)^(Data[pos+1]<<5)^Data[pos+2])&WindowMask;
+}
+
+inline void Deflater::insert(size_t pos)
+{
+    if(pos+3>Data.size())return;
+    int hash=hashAt(pos);
+    Prev[pos&WindowMask]=Head[hash];
+    Head[hash]=static_cast<int>(pos);
+}
+
+// Longest earlier match for pos that ends before end; 0 if none of length 3+
+int Deflater::findMatch(size_t pos,size_t end,int*distance) const
+{
+    int limit=static_cast<int>(std::min<size_t>(258,end-pos));
+    if(limit<3)return 0;
+    int best=2;
+    int chain=MaxChain;
+    const unsigned char*here=Data.data()+pos;
+    for(int candidate=Head[hashAt(pos)];candidate>=0&&chain-->0;candidate=Prev[candidate&WindowMask])
+    {
+        size_t back=pos-candidate;
+        if(back==0||back>WindowSize)break;
+        const unsigned char*there=Data.data()+candidate;
+        if(there[best]!=here[best]||there[0]!=here[0])continue;
+        int length=0;
+        while(length<limit&&there[length]==here[length])length++;
+        if(length>best)
+        {
+            best=length;
+            *distance=static_cast<int>(back);
+            if(length>=NiceLength||length==limit)break;
+        }
+    }
+    return best>=3?best:0;
+}
+
+// LZ77 over [Start,end) into Tokens
+void Deflater::tokenize(size_t end)
+{
+    Tokens.clear();
+    size_t pos=Start;
+    while(pos<end)
+    {
+        int distance=0;
+        int length=findMatch(pos,end,&distance);
+        insert(pos);
+        if(length&&Lazy&&length<NiceLength&&pos+1<end)
+        {
+            // Prefer a literal now if the next position matches longer
+            int nextDistance=0;
+            if(findMatch(pos+1,end,&nextDistance)>length)
+            {
+                Tokens.push_back({Data[pos],0});
+                pos++;
+                continue;
+            }
+        }
+        if(length==0)
+        {
+            Tokens.push_back({Data[pos],0});
+            pos++;
+            continue;
+        }
+        Tokens.push_back({static_cast<unsigned short>(length),static_cast<unsigned short>(distance)});
+        for(int i=1;i<length;i++)insert(pos+i);
+        pos+=length;
+    }
+}
+
+void Deflater::writeStored(size_t end,bool final,std::vector<char>&out)
+{
+    putBits(final?1:0,1,out);
+    putBits(0,2,out);
+    alignToByte(out);
+    unsigned length=static_cast<unsigned>(end-Start);
+    putBits(length,16,out);
+    putBits(length^0xFFFF,16,out);
+    out.insert(out.end(),Data.begin()+Start,Data.begin()+end);
+}
+
+// Emit [Start,end) as whichever of stored, fixed or dynamic Huffman is smallest
+void Deflater::writeBlock(size_t end,bool final,std::vector<char>&out)
+{
+    if(Level==0)
+    {
+        writeStored(end,final,out);
+        return;
+    }
+    tokenize(end);
+
+    unsigned litFreq[286]={0},distFreq[30]={0};
+    for(const Token&token:Tokens)
+    {
+        if(token.Distance==0){litFreq[token.LitOrLength]++;continue;}
+        int symbol,extraBits,extraValue;
+        lengthSymbol(token.LitOrLength,&symbol,&extraBits,&extraValue);
+        litFreq[symbol]++;
+        distanceSymbol(token.Distance,&symbol,&extraBits,&extraValue);
+        distFreq[symbol]++;
+    }
+    litFreq[256]=1;
+
+    unsigned char litLengths[288]={0},distLengths[30]={0};
+    huffmanLengths(litFreq,286,15,litLengths);
+    huffmanLengths(distFreq,30,15,distLengths);
+    // Some decoders reject a block without any distance code
+    if(std::all_of(distLengths,distLengths+30,[](unsigned char l){return l==0;}))distLengths[0]=1;
+
+    int litCount=286,distCount=30;
+    while(litCount>257&&litLengths[litCount-1]==0)litCount--;
+    while(distCount>1&&distLengths[distCount-1]==0)distCount--;
+
+    // Run-length encode both length lists with symbols 16/17/18
+    unsigned char all[316];
+    std::memcpy(all,litLengths,litCount);
+    std::memcpy(all+litCount,distLengths,distCount);
+    int allCount=litCount+distCount;
+    struct Run{unsigned char Symbol,Extra;};
+    std::vector<Run> runs;
+    unsigned clFreq[19]={0};
+    for(int i=0;i<allCount;)
+    {
+        int value=all[i],run=1;
+        while(i+run<allCount&&all[i+run]==value)run++;
+        int left=run;
+        if(value==0)
+        {
+            while(left>=11){int n=std::min(left,138);runs.push_back({18,(unsigned char)(n-11)});left-=n;}
+            if(left>=3){runs.push_back({17,(unsigned char)(left-3)});left=0;}
+        }
+        else
+        {
+            runs.push_back({(unsigned char)value,0});
+            left--;
+            while(left>=3){int n=std::min(left,6);runs.push_back({16,(unsigned char)(n-3)});left-=n;}
+        }
+        while(left-->0)runs.push_back({(unsigned char)value,0});
+        i+=run;
+    }
+    for(const Run&r:runs)clFreq[r.Symbol]++;
+    unsigned char clLengths[19];
+    huffmanLengths(clFreq,19,7,clLengths);
+    int clCount=19;
+    while(clCount>4&&clLengths[CodeLengthOrder[clCount-1]]==0)clCount--;
+
+    // Size of each encoding in bits
+    unsigned char fixedLit[288],fixedDist[30];
+    fixedLengths(fixedLit,fixedDist);
+    unsigned long long extraBitsTotal=0,dynamicBits=0,fixedBits=0;
+    for(int i=0;i<286;i++)
+    {
+        dynamicBits+=static_cast<unsigned long long>(litFreq[i])*litLengths[i];
+        fixedBits+=static_cast<unsigned long long>(litFreq[i])*fixedLit[i];
+        if(i>=257)extraBitsTotal+=static_cast<unsigned long long>(litFreq[i])*LengthExtra[i-257];
+    }
+    for(int i=0;i<30;i++)
+    {
+        dynamicBits+=static_cast<unsigned long long>(distFreq[i])*distLengths[i];
+        fixedBits+=static_cast<unsigned long long>(distFreq[i])*5;
+        extraBitsTotal+=static_cast<unsigned long long>(distFreq[i])*DistanceExtra[i];
+    }
+    dynamicBits+=extraBitsTotal+14+3*clCount;
+    for(const Run&r:runs)dynamicBits+=clLengths[r.Symbol]+(r.Symbol==16?2:r.Symbol==17?3:r.Symbol==18?7:0);
+    fixedBits+=extraBitsTotal;
+    unsigned long long storedBits=(end-Start+5)*8ull;
+
+    if(storedBits<=dynamicBits&&storedBits<=fixedBits)
+    {
+        writeStored(end,final,out);
+        return;
+    }
+
+    const unsigned char*useLit=litLengths;
+    const unsigned char*useDist=distLengths;
+    putBits(final?1:0,1,out);
+    if(fixedBits<=dynamicBits)
+    {
+        putBits(1,2,out);
+        useLit=fixedLit;
+        useDist=fixedDist;
+    }
+    else
+    {
+        putBits(2,2,out);
+        putBits(litCount-257,5,out);
+        putBits(distCount-1,5,out);
+        putBits(clCount-4,4,out);
+        for(int i=0;i<clCount;i++)putBits(clLengths[CodeLengthOrder[i]],3,out);
+        unsigned short clCodes[19];
+        canonicalCodes(clLengths,19,clCodes);
+        for(const Run&r:runs)
+        {
+            putBits(clCodes[r.Symbol],clLengths[r.Symbol],out);
+            if(r.Symbol==16)putBits(r.Extra,2,out);
+            else if(r.Symbol==17)putBits(r.Extra,3,out);
+            else if(r.Symbol==18)putBits(r.Extra,7,out);
+        }
+    }
+
+    unsigned short litCodes[288],distCodes[30];
+    canonicalCodes(useLit,288,litCodes);
+    canonicalCodes(useDist,30,distCodes);
+    for(const Token&token:Tokens)
+    {
+        if(token.Distance==0)
+        {
+            putBits(litCodes[token.LitOrLength],useLit[token.LitOrLength],out);
+            continue;
+        }
+        int symbol,extraBits,extraValue;
+        lengthSymbol(token.LitOrLength,&symbol,&extraBits,&extraValue);
+        putBits(litCodes[symbol],useLit[symbol],out);
+        if(extraBits)putBits(extraValue,extraBits,out);
+        distanceSymbol(token.Distance,&symbol,&extraBits,&extraValue);
+        putBits(distCodes[symbol],useDist[symbol],out);
+        if(extraBits)putBits(extraValue,extraBits,out);
+    }
+    putBits(litCodes[256],useLit[256],out);
+}
+
+// Drop history older than the window, keeping hash positions consistent
+void Deflater::slide()
+{
+    if(Start<=WindowSize)return;
+    size_t shift=Start-WindowSize;
+    Data.erase(Data.begin(),Data.begin()+shift);
+    Start-=shift;
+    const auto rebase=[shift](int&pos){pos=pos>=static_cast<int>(shift)?pos-static_cast<int>(shift):-1;};
+    std::for_each(Head.begin(),Head.end(),rebase);
+    // Prev is indexed by position modulo the window, so entries move with it
+    std::vector<int> moved(WindowSize,-1);
+    for(size_t pos=0;pos<Start;pos++)
+    {
+        int link=Prev[(pos+shift)&WindowMask];
+        rebase(link);
+        moved[pos&WindowMask]=link;
+    }
+    Prev.swap(moved);
+}
+
+void Deflater::compressPending(bool final,std::vector<char>&out)
+{
+    if(!HeaderWritten)
+    {
+        static constexpr char header[10]={0x1F,char(0x8B),8,0,0,0,0,0,0,char(0xFF)};
+        out.insert(out.end(),header,header+10);
+        HeaderWritten=true;
+    }
+    writeBlock(Data.size(),final,out);
+    Start=Data.size();
+    slide();
+}
+
+void Deflater::write(const char*data,size_t length,std::vector<char>&out)
+{
+    Crc=crc32(Crc,data,length);
+    Size+=static_cast<std::uint32_t>(length);
+    while(length>0)
+    {
+        size_t room=BlockSize-(Data.size()-Start);
+        size_t chunk=std::min(room,length);
+        Data.insert(Data.end(),data,data+chunk);
+        data+=chunk;
+        length-=chunk;
+        if(Data.size()-Start==BlockSize)compressPending(false,out);
+    }
+}
+
+void Deflater::finish(std::vector<char>&out)
+{
+    compressPending(true,out);
+    alignToByte(out);
+    for(std::uint32_t value:{Crc,Size})
+        for(int i=0;i<4;i++)out.push_back(static_cast<char>((value>>(8*i))&0xFF));
+}
+
+#endif
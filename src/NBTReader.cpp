@@ -26,144 +26,430 @@ This file is part of SlopeCraft.
 #include "NBTReader.h"
 #include <iostream>
 
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 using namespace NBT;
 
-// Constructor - read root compound header
-NBTReader::NBTReader(const char*path)
+MappedFile::MappedFile()
 {
-    isBE=isSysBE();
-    ByteCount=0;
-    File=new std::ifstream(path,std::ios::in|std::ios::binary);
+    Data=nullptr;
+    Length=0;
+    isMapped=false;
+#ifdef _WIN32
+    FileHandle=nullptr;
+    MapHandle=nullptr;
+#endif
+}
 
-    if (!File->is_open()) {
+MappedFile::MappedFile(const char*path)
+    : MappedFile()
+{
+    if (!open(path)) {
         throw std::runtime_error("Failed to open file for reading");
     }
+}
+
+MappedFile::~MappedFile()
+{
+    release();
+}
 
-    // Read root compound: [10, 0, 0]
-    char header[3];
-    File->read(header, 3);
-    ByteCount+=3;
+MappedFile::MappedFile(MappedFile&&other) noexcept
+    : MappedFile()
+{
+    *this=std::move(other);
+}
 
-    if (File->eof() || File->fail()) {
-        throw std::runtime_error("Failed to read NBT header");
+MappedFile&MappedFile::operator=(MappedFile&&other) noexcept
+{
+    if (this!=&other) {
+        release();
+        Data=other.Data;
+        Length=other.Length;
+        isMapped=other.isMapped;
+        Fallback=std::move(other.Fallback);
+        if (!isMapped && !Fallback.empty()) {
+            Data=Fallback.data();
+        }
+#ifdef _WIN32
+        FileHandle=other.FileHandle;
+        MapHandle=other.MapHandle;
+        other.FileHandle=nullptr;
+        other.MapHandle=nullptr;
+#endif
+        other.Data=nullptr;
+        other.Length=0;
+        other.isMapped=false;
     }
+    return *this;
+}
 
-    if (header[0] != idCompound || header[1] != 0 || header[2] != 0) {
-        throw std::runtime_error("Invalid NBT file: missing root compound");
+// Map the whole file; returns false only when it cannot be opened at all
+bool MappedFile::open(const char*path)
+{
+    release();
+#ifdef _WIN32
+    HANDLE file=CreateFileA(path,GENERIC_READ,FILE_SHARE_READ,nullptr,
+                            OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,nullptr);
+    if (file!=INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER fileSize;
+        if (GetFileSizeEx(file,&fileSize) && fileSize.QuadPart>0) {
+            HANDLE mapping=CreateFileMappingA(file,nullptr,PAGE_READONLY,0,0,nullptr);
+            if (mapping!=nullptr) {
+                void*view=MapViewOfFile(mapping,FILE_MAP_READ,0,0,0);
+                if (view!=nullptr) {
+                    FileHandle=file;
+                    MapHandle=mapping;
+                    Data=static_cast<const char*>(view);
+                    Length=static_cast<size_t>(fileSize.QuadPart);
+                    isMapped=true;
+                    return true;
+                }
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(file);
     }
+#else
+    int fd=::open(path,O_RDONLY);
+    if (fd>=0) {
+        struct stat info;
+        if (fstat(fd,&info)==0 && S_ISREG(info.st_mode) && info.st_size>0) {
+            void*view=mmap(nullptr,static_cast<size_t>(info.st_size),PROT_READ,MAP_PRIVATE,fd,0);
+            if (view!=MAP_FAILED) {
+                ::close(fd);
+#ifdef MADV_SEQUENTIAL
+                madvise(view,static_cast<size_t>(info.st_size),MADV_SEQUENTIAL);
+#endif
+                Data=static_cast<const char*>(view);
+                Length=static_cast<size_t>(info.st_size);
+                isMapped=true;
+                return true;
+            }
+        }
+        ::close(fd);
+    }
+#endif
 
-    isOpen=true;
-    for(top=0;top<TwinStackSize;top++)
-    {
-        CLA[top]=114;
-        Size[top]=114514;
+    // Not mappable (empty file, pipe, ...): read it in one go instead
+    std::ifstream in(path,std::ios::in|std::ios::binary);
+    if (!in.is_open()) {
+        return false;
     }
+    Fallback.assign(std::istreambuf_iterator<char>(in),std::istreambuf_iterator<char>());
+    Data=Fallback.data();
+    Length=Fallback.size();
+    return true;
+}
 
-    top=-1;
-    push(idEnd, 0);  // We're now inside the root compound
+void MappedFile::close()
+{
+    release();
+}
+
+void MappedFile::release()
+{
+    if (isMapped) {
+#ifdef _WIN32
+        UnmapViewOfFile(Data);
+        CloseHandle(MapHandle);
+        CloseHandle(FileHandle);
+        MapHandle=nullptr;
+        FileHandle=nullptr;
+#else
+        munmap(const_cast<char*>(Data),Length);
+#endif
+    }
+    std::vector<char>().swap(Fallback);
+    Data=nullptr;
+    Length=0;
+    isMapped=false;
+}
+
+// Inflated bytes kept in memory at a time for gzip input
+static constexpr size_t StreamBlockSize = 65536;
+
+// Payload size of the fixed-width tag types, 0 for the others
+static long long fixedTagWidth(char typeId)
+{
+    switch(typeId) {
+        case idByte: return 1;
+        case idShort: return 2;
+        case idInt:
+        case idFloat: return 4;
+        case idLong:
+        case idDouble: return 8;
+        default: return 0;
+    }
+}
+
+// Name of a tag type as used in error messages
+static const char* tagTypeName(char typeId)
+{
+    switch(typeId) {
+        case idEnd: return "END";
+        case idByte: return "BYTE";
+        case idShort: return "SHORT";
+        case idInt: return "INT";
+        case idLong: return "LONG";
+        case idFloat: return "FLOAT";
+        case idDouble: return "DOUBLE";
+        case idByteArray: return "BYTE_ARRAY";
+        case idString: return "STRING";
+        case idList: return "LIST";
+        case idCompound: return "COMPOUND";
+        case idIntArray: return "INT_ARRAY";
+        case idLongArray: return "LONG_ARRAY";
+        default: return "UNKNOWN";
+    }
 }
 
-NBTReader::NBTReader()
+std::string Error::message() const
 {
-    isBE=isSysBE();
-    ByteCount=0;
-    File=NULL;
+    std::string text;
+    switch(code) {
+        case ErrorCode::OpenFailed:
+            text = "Failed to open file for reading";
+            break;
+        case ErrorCode::BadHeader:
+            text = "Invalid NBT file: missing root compound";
+            break;
+        case ErrorCode::NotOpen:
+            text = "File not open";
+            break;
+        case ErrorCode::UnexpectedEof:
+            text = "Unexpected EOF in NBT data";
+            break;
+        case ErrorCode::NegativeLength:
+            text = "Negative length in NBT data";
+            break;
+        case ErrorCode::UnknownTagType:
+            text = "Unknown tag type in NBT data";
+            break;
+        case ErrorCode::TypeMismatch:
+            text = std::string("Expected ") + tagTypeName(expectedType) + " tag";
+            break;
+        case ErrorCode::ListTypeMismatch:
+            text = "Type mismatch in list";
+            break;
+        case ErrorCode::NameMismatch:
+            text = "Expected tag name '" + expectedName + "' but got '" + actualName + "'";
+            break;
+        case ErrorCode::NotInCompound:
+            text = "Not in compound";
+            break;
+        case ErrorCode::MissingEnd:
+            text = "Expected TAG_END";
+            break;
+        case ErrorCode::ArrayOverrun:
+            text = "Read past the end of the array";
+            break;
+        case ErrorCode::CorruptCompression:
+            text = "Corrupt gzip data: " + actualName;
+            break;
+        case ErrorCode::TooDeep:
+            text = "NBT nested too deeply";
+            break;
+        case ErrorCode::NotSeekable:
+            text = "Can't seek in gzip-compressed NBT";
+            break;
+    }
+    return text + " (at byte " + std::to_string(offset) + ")";
+}
+
+// Throwing API: unwrap a Result or raise its error
+template<typename T>
+static T unwrap(Result<T>&& result)
+{
+    if (!result) {
+        throw std::runtime_error(result.error().message());
+    }
+    if constexpr (!std::is_void_v<T>) {
+        return std::move(*result);
+    }
+}
+
+// Constructor - map the file and read root compound header
+template<std::endian Order>
+BasicNBTReader<Order>::BasicNBTReader(const char*path)
+    : BasicNBTReader()
+{
+    open(path);
+}
+
+template<std::endian Order>
+BasicNBTReader<Order>::BasicNBTReader(std::span<const std::byte> data)
+    : BasicNBTReader()
+{
+    unwrap(tryOpen(data));
+}
+
+template<std::endian Order>
+BasicNBTReader<Order>::BasicNBTReader()
+{
+    Begin=Cursor=End=nullptr;
+    StreamBase=0;
     isOpen=false;
-    for(top=0;top<TwinStackSize;top++)
+}
+
+template<std::endian Order>
+void BasicNBTReader<Order>::open(const char*path)
+{
+    unwrap(tryOpen(path));
+}
+
+template<std::endian Order>
+Result<void> BasicNBTReader<Order>::tryOpen(const char*path)
+{
+    if(isOpen)
     {
-        CLA[top]=114;
-        Size[top]=114514;
+        return {};
+    }
+    if (!Mapping.open(path)) {
+        return fail(ErrorCode::OpenFailed);
     }
 
-    top=-1;
+    return startInput(Mapping.data(), Mapping.size());
 }
 
-void NBTReader::open(const char*path)
+template<std::endian Order>
+Result<void> BasicNBTReader<Order>::tryOpen(std::span<const std::byte> data)
 {
     if(isOpen)
     {
-        return;
+        return {};
     }
-    File=new std::ifstream(path,std::ios::in|std::ios::binary);
+    return startInput(reinterpret_cast<const char*>(data.data()), data.size());
+}
 
-    if (!File->is_open()) {
-        throw std::runtime_error("Failed to open file for reading");
+// Raw NBT is decoded in place; gzip input is inflated into Stream piece by
+// piece as the decoder asks for bytes
+template<std::endian Order>
+Result<void> BasicNBTReader<Order>::startInput(const char*data, size_t length)
+{
+    Begin=Cursor=data;
+    End=data+length;
+    StreamBase=0;
+    if (isGzip(data, length)) {
+        Inflate=std::make_unique<Inflater>(data, length);
+        Stream.resize(StreamBlockSize);
+        Begin=Cursor=End=Stream.data();
     }
+    return readHeader();
+}
 
-    // Read root compound: [10, 0, 0]
-    char header[3];
-    File->read(header, 3);
-    ByteCount+=3;
+// Read root compound: [10, 0, 0]
+template<std::endian Order>
+Result<void> BasicNBTReader<Order>::readHeader()
+{
+    // Bedrock level.dat: int32 storage version and int32 payload length
+    // before the root. Recognised by the length matching the rest of the file.
+    if constexpr (Order == std::endian::little) {
+        if (!Inflate && End-Cursor >= 11) {
+            int payloadLength;
+            std::memcpy(&payloadLength, Cursor+4, 4);
+            if constexpr (NeedsSwap) {
+                IE2BE(payloadLength);
+            }
+            if (payloadLength == End-Cursor-8 && Cursor[8] == idCompound) {
+                Cursor += 8;
+            }
+        }
+    }
 
-    if (File->eof() || File->fail()) {
-        throw std::runtime_error("Failed to read NBT header");
+    if (auto ok = require(3); !ok) {
+        return ok;
     }
 
-    if (header[0] != idCompound || header[1] != 0 || header[2] != 0) {
-        throw std::runtime_error("Invalid NBT file: missing root compound");
+    if (Cursor[0] != idCompound || Cursor[1] != 0 || Cursor[2] != 0) {
+        return fail(ErrorCode::BadHeader);
     }
+    Cursor+=3;
 
     isOpen=true;
     push(idEnd, 0);  // We're now inside the root compound
+    return {};
 }
 
 
-NBTReader::~NBTReader()
+template<std::endian Order>
+BasicNBTReader<Order>::~BasicNBTReader()
 {
     if(isOpen)close();
-    delete File;
     return;
 }
 
-void NBTReader::close()
+template<std::endian Order>
+void BasicNBTReader<Order>::close()
 {
     if(isOpen)
     {
-        File->close();
+        Mapping.close();
+        Inflate.reset();
+        std::vector<char>().swap(Stream);
+        Begin=Cursor=End=nullptr;
+        StreamBase=0;
+        isOpen=false;
     }
 }
 
-bool NBTReader::isEmpty()
-{
-    return (top==-1);
-}
-
-bool NBTReader::isFull()
+template<std::endian Order>
+bool BasicNBTReader<Order>::isEmpty()
 {
-    return top>=TwinStackSize;
+    return Stack.empty();
 }
 
-bool NBTReader::isListFinished()
+template<std::endian Order>
+bool BasicNBTReader<Order>::isListFinished()
 {
-    return (Size[top]<=0);
+    return (Stack.size()<=0);
 }
 
-char NBTReader::readType()
+template<std::endian Order>
+char BasicNBTReader<Order>::readType()
 {
-    return CLA[top];
+    return Stack.type();
 }
 
-int NBTReader::readSize()
+template<std::endian Order>
+int BasicNBTReader<Order>::readSize()
 {
-    return Size[top];
+    return Stack.size();
 }
 
-bool NBTReader::isInCompound()
+template<std::endian Order>
+bool BasicNBTReader<Order>::isInCompound()
 {
     return isEmpty()||(readType()==0);
 }
 
-bool NBTReader::isInList()
+template<std::endian Order>
+bool BasicNBTReader<Order>::isInList()
 {
     return !isInCompound();
 }
 
-bool NBTReader::typeMatch(char typeId)
+template<std::endian Order>
+bool BasicNBTReader<Order>::typeMatch(char typeId)
 {
     return(readType()==typeId);
 }
 
-void NBTReader::endList()
+template<std::endian Order>
+void BasicNBTReader<Order>::endList()
 {
     if(isInList()&&isListFinished())
     {
@@ -173,529 +459,1112 @@ void NBTReader::endList()
     return;
 }
 
-void NBTReader::pop()
+template<std::endian Order>
+void BasicNBTReader<Order>::pop()
 {
-    if(!isEmpty()){
-    top--;
-    }
-    else
-        ;
-    return;
+    Stack.pop();
 }
 
-void NBTReader::push(char typeId,int size)
+template<std::endian Order>
+void BasicNBTReader<Order>::push(char typeId,int size)
 {
-    if(!isFull())
-    {
-        top++;
-        CLA[top]=typeId;
-        Size[top]=size;
-    }
-    else
-    return;
+    Stack.push(typeId,size);
 }
 
-void NBTReader::elementRead()
+template<std::endian Order>
+void BasicNBTReader<Order>::elementRead()
 {
     if(isInList()&&!isListFinished())
-    Size[top]--;
+    Stack.size()--;
     if(isListFinished())
     endList();
     return;
 }
 
+template<std::endian Order>
+std::unexpected<Error> BasicNBTReader<Order>::fail(ErrorCode code,char expectedType)
+{
+    return std::unexpected(Error{code, getByteCount(), expectedType, {}, {}});
+}
+
+// Make sure n more bytes are available at Cursor
+template<std::endian Order>
+inline Result<void> BasicNBTReader<Order>::require(size_t n)
+{
+    if (static_cast<size_t>(End-Cursor) < n) {
+        return refill(n);
+    }
+    return {};
+}
+
+// Move the unread bytes to the front of Stream and inflate more after them.
+// Views into the bytes already consumed are invalid afterwards.
+template<std::endian Order>
+Result<void> BasicNBTReader<Order>::refill(size_t n)
+{
+    if (!Inflate) {
+        return fail(ErrorCode::UnexpectedEof);
+    }
+
+    size_t kept = End-Cursor;
+    StreamBase += Cursor-Begin;
+    std::memmove(Stream.data(), Cursor, kept);
+    if (Stream.size() < n) {
+        Stream.resize(n);
+    }
+    kept += Inflate->read(Stream.data()+kept, Stream.size()-kept);
+    Begin=Cursor=Stream.data();
+    End=Begin+kept;
+
+    // A bad checksum surfaces with the last bytes, so fail even if enough arrived
+    if (Inflate->failed()) {
+        Error error = fail(ErrorCode::CorruptCompression).error();
+        error.actualName = Inflate->errorMessage();
+        return std::unexpected(error);
+    }
+    if (kept < n) {
+        return fail(ErrorCode::UnexpectedEof);
+    }
+    return {};
+}
+
+// Step over n payload bytes, rejecting negative lengths read from the file
+template<std::endian Order>
+Result<void> BasicNBTReader<Order>::advance(long long n)
+{
+    if (n < 0) {
+        return fail(ErrorCode::NegativeLength);
+    }
+    // Long skips over gzip input go window by window instead of growing it
+    while (Inflate && End-Cursor < n) {
+        n -= End-Cursor;
+        Cursor = End;
+        if (auto ok = refill(1); !ok) {
+            return ok;
+        }
+    }
+    if (auto ok = require(static_cast<size_t>(n)); !ok) {
+        return ok;
+    }
+    Cursor += n;
+    return {};
+}
+
+// Copy n bytes out, window by window for gzip input
+template<std::endian Order>
+Result<void> BasicNBTReader<Order>::copyOut(char* out, size_t n)
+{
+    while (Inflate && static_cast<size_t>(End-Cursor) < n) {
+        size_t part = End-Cursor;
+        std::memcpy(out, Cursor, part);
+        out += part;
+        n -= part;
+        Cursor = End;
+        if (auto ok = refill(1); !ok) {
+            return ok;
+        }
+    }
+    if (auto ok = require(n); !ok) {
+        return ok;
+    }
+    std::memcpy(out, Cursor, n);
+    Cursor += n;
+    return {};
+}
+
 // Template for reading values with endianness conversion
+template<std::endian Order>
 template<typename T>
-T NBTReader::readValue()
+Result<T> BasicNBTReader<Order>::readValue()
 {
-    T value;
-    File->read(reinterpret_cast<char*>(&value), sizeof(T));
-    ByteCount += sizeof(T);
-
-    if (File->eof() || File->fail()) {
-        throw std::runtime_error("Unexpected EOF while reading value");
+    if (auto ok = require(sizeof(T)); !ok) {
+        return std::unexpected(ok.error());
     }
+    T value;
+    std::memcpy(&value, Cursor, sizeof(T));
+    Cursor += sizeof(T);
 
-    if (!isBE && sizeof(T) > 1) {
+    if constexpr (NeedsSwap) {
         IE2BE(value);  // IE2BE and BE2IE are the same operation (byte swap)
     }
     return value;
 }
 
-char NBTReader::CurrentType()
+// String and name lengths are unsigned 16-bit in NBT
+template<std::endian Order>
+Result<unsigned short> BasicNBTReader<Order>::readLength16()
+{
+    auto length = readValue<short>();
+    if (!length) {
+        return std::unexpected(length.error());
+    }
+    return static_cast<unsigned short>(*length);
+}
+
+template<std::endian Order>
+char BasicNBTReader<Order>::CurrentType()
 {
     return readType();
 }
 
-unsigned long long NBTReader::getByteCount()
+template<std::endian Order>
+unsigned long long BasicNBTReader<Order>::getByteCount()
 {
-    return ByteCount;
+    return StreamBase+static_cast<unsigned long long>(Cursor-Begin);
 }
 
 // Peek at next tag type without consuming
-char NBTReader::peekTagType()
+template<std::endian Order>
+Result<char> BasicNBTReader<Order>::tryPeekTagType()
 {
     if (!isOpen) {
-        throw std::runtime_error("File not open");
+        return fail(ErrorCode::NotOpen);
     }
-
-    char type;
-    File->read(&type, 1);
-    if (File->eof() || File->fail()) {
-        throw std::runtime_error("Unexpected EOF while peeking tag type");
+    if (auto ok = require(1); !ok) {
+        return std::unexpected(ok.error());
     }
+    return *Cursor;
+}
 
-    // Seek back one byte
-    File->seekg(-1, std::ios::cur);
-    return type;
+template<std::endian Order>
+char BasicNBTReader<Order>::peekTagType()
+{
+    return unwrap(tryPeekTagType());
 }
 
 // Read tag type byte
-char NBTReader::readTagType()
+template<std::endian Order>
+Result<char> BasicNBTReader<Order>::tryReadTagType()
 {
-    char type;
-    File->read(&type, 1);
-    ByteCount += 1;
-
-    if (File->eof() || File->fail()) {
-        throw std::runtime_error("Unexpected EOF while reading tag type");
+    if (auto ok = require(1); !ok) {
+        return std::unexpected(ok.error());
     }
+    return *Cursor++;
+}
 
-    return type;
+template<std::endian Order>
+char BasicNBTReader<Order>::readTagType()
+{
+    return unwrap(tryReadTagType());
 }
 
 // Read tag name (length + string)
-std::string NBTReader::readTagName()
+template<std::endian Order>
+std::string BasicNBTReader<Order>::readTagName()
 {
-    short nameLength = readValue<short>();
-    std::string name(nameLength, '\0');
-    File->read(&name[0], nameLength);
-    ByteCount += nameLength;
+    return std::string(readTagNameView());
+}
 
-    if (File->eof() || File->fail()) {
-        throw std::runtime_error("Unexpected EOF while reading tag name");
+// Read tag name without copying; the view points into the mapped input
+template<std::endian Order>
+Result<std::string_view> BasicNBTReader<Order>::tryReadTagNameView()
+{
+    return tryReadStringPayloadView();
+}
+
+template<std::endian Order>
+std::string_view BasicNBTReader<Order>::readTagNameView()
+{
+    return unwrap(tryReadTagNameView());
+}
+
+// Read a full tag header in compound context and check type and name
+template<std::endian Order>
+Result<void> BasicNBTReader<Order>::matchTagHeader(char typeId, const char* expectedName)
+{
+    auto type = tryReadTagType();
+    if (!type) {
+        return std::unexpected(type.error());
+    }
+    if (*type != typeId) {
+        return fail(ErrorCode::TypeMismatch, typeId);
     }
 
-    return name;
+    auto name = tryReadTagNameView();
+    if (!name) {
+        return std::unexpected(name.error());
+    }
+    if (expectedName != nullptr && *name != expectedName) {
+        Error error = fail(ErrorCode::NameMismatch).error();
+        error.expectedName = expectedName;
+        error.actualName = *name;
+        return std::unexpected(error);
+    }
+    return {};
+}
+
+// Read just the value of a tag whose header has already been consumed
+template<std::endian Order>
+Result<char> BasicNBTReader<Order>::tryReadBytePayload()
+{
+    return readValue<char>();
+}
+
+template<std::endian Order>
+char BasicNBTReader<Order>::readBytePayload()
+{
+    return unwrap(tryReadBytePayload());
+}
+
+template<std::endian Order>
+Result<std::string_view> BasicNBTReader<Order>::tryReadStringPayloadView()
+{
+    auto length = readLength16();
+    if (!length) {
+        return std::unexpected(length.error());
+    }
+    if (auto ok = require(*length); !ok) {
+        return std::unexpected(ok.error());
+    }
+    std::string_view result(Cursor, *length);
+    Cursor += *length;
+    return result;
+}
+
+template<std::endian Order>
+std::string_view BasicNBTReader<Order>::readStringPayloadView()
+{
+    return unwrap(tryReadStringPayloadView());
 }
 
 // Skip a tag based on its type
-void NBTReader::skipTag(char tagType)
+template<std::endian Order>
+Result<void> BasicNBTReader<Order>::trySkipTag(char tagType)
 {
-    switch(tagType) {
-        case idByte:
-            File->seekg(1, std::ios::cur);
-            ByteCount += 1;
-            break;
-        case idShort:
-            File->seekg(2, std::ios::cur);
-            ByteCount += 2;
-            break;
-        case idInt:
-        case idFloat:
-            File->seekg(4, std::ios::cur);
-            ByteCount += 4;
-            break;
-        case idLong:
-        case idDouble:
-            File->seekg(8, std::ios::cur);
-            ByteCount += 8;
-            break;
-        case idString: {
-            short length = readValue<short>();
-            File->seekg(length, std::ios::cur);
-            ByteCount += length;
-            break;
+    return skipListElements(tagType, 1);
+}
+
+template<std::endian Order>
+void BasicNBTReader<Order>::skipTag(char tagType)
+{
+    unwrap(trySkipTag(tagType));
+}
+
+template<std::endian Order>
+Result<void> BasicNBTReader<Order>::trySkipCurrentTag()
+{
+    if (isInCompound()) {
+        auto type = tryReadTagType();
+        if (!type) {
+            return std::unexpected(type.error());
         }
-        case idByteArray: {
-            int length = readValue<int>();
-            File->seekg(length, std::ios::cur);
-            ByteCount += length;
-            break;
+        if (auto name = tryReadTagNameView(); !name) {
+            return std::unexpected(name.error());
         }
-        case idIntArray: {
-            int count = readValue<int>();
-            File->seekg(count * 4, std::ios::cur);
-            ByteCount += count * 4;
-            break;
+        return trySkipTag(*type);
+    }
+
+    if (auto ok = trySkipTag(readType()); !ok) {
+        return ok;
+    }
+    elementRead();
+    return {};
+}
+
+template<std::endian Order>
+void BasicNBTReader<Order>::skipCurrentTag()
+{
+    unwrap(trySkipCurrentTag());
+}
+
+// Skip count payloads of elementType. Iterative with a fixed stack of open
+// containers, so neither the call stack nor the heap grows with nesting;
+// names and strings are stepped over unread, and runs of fixed-width list
+// elements go in a single advance()
+template<std::endian Order>
+Result<void> BasicNBTReader<Order>::skipListElements(char elementType, int count)
+{
+    struct Frame
+    {
+        bool isCompound;
+        char elementType;
+        int remaining;
+    };
+    Frame frames[VisitDepthLimit];
+    int depth = 0;
+    frames[0] = {false, elementType, count};
+
+    while (depth >= 0) {
+        Frame& frame = frames[depth];
+        char type;
+        if (frame.isCompound) {
+            auto tag = tryReadTagType();
+            if (!tag) {
+                return std::unexpected(tag.error());
+            }
+            if (*tag == idEnd) {
+                depth--;
+                continue;
+            }
+            auto nameLength = readLength16();
+            if (!nameLength) {
+                return std::unexpected(nameLength.error());
+            }
+            if (auto ok = advance(*nameLength); !ok) {
+                return ok;
+            }
+            type = *tag;
+        } else {
+            if (long long width = fixedTagWidth(frame.elementType); width != 0) {
+                if (auto ok = advance(frame.remaining * width); !ok) {
+                    return ok;
+                }
+                depth--;
+                continue;
+            }
+            if (frame.remaining <= 0) {
+                depth--;
+                continue;
+            }
+            frame.remaining--;
+            type = frame.elementType;
         }
-        case idLongArray: {
-            int count = readValue<int>();
-            File->seekg(count * 8, std::ios::cur);
-            ByteCount += count * 8;
-            break;
+
+        switch(type) {
+            case idByte:
+            case idShort:
+            case idInt:
+            case idFloat:
+            case idLong:
+            case idDouble:
+                if (auto ok = advance(fixedTagWidth(type)); !ok) {
+                    return ok;
+                }
+                break;
+            case idString: {
+                auto length = readLength16();
+                if (!length) {
+                    return std::unexpected(length.error());
+                }
+                if (auto ok = advance(*length); !ok) {
+                    return ok;
+                }
+                break;
+            }
+            case idByteArray:
+            case idIntArray:
+            case idLongArray: {
+                long long width = type == idByteArray ? 1 : type == idIntArray ? 4 : 8;
+                auto length = readValue<int>();
+                if (!length) {
+                    return std::unexpected(length.error());
+                }
+                if (auto ok = advance(*length * width); !ok) {
+                    return ok;
+                }
+                break;
+            }
+            case idList: {
+                auto listType = readValue<char>();
+                if (!listType) {
+                    return std::unexpected(listType.error());
+                }
+                auto length = readValue<int>();
+                if (!length) {
+                    return std::unexpected(length.error());
+                }
+                if (*length < 0) {
+                    return fail(ErrorCode::NegativeLength);
+                }
+                if (depth + 1 >= VisitDepthLimit) {
+                    return fail(ErrorCode::TooDeep);
+                }
+                frames[++depth] = {false, *listType, *length};
+                break;
+            }
+            case idCompound:
+                if (depth + 1 >= VisitDepthLimit) {
+                    return fail(ErrorCode::TooDeep);
+                }
+                frames[++depth] = {true, idEnd, 0};
+                break;
+            default:
+                return fail(ErrorCode::UnknownTagType);
         }
-        case idList: {
-            char elementType = readValue<char>();
-            int count = readValue<int>();
-            for (int i = 0; i < count; i++) {
-                skipTag(elementType);
+    }
+    return {};
+}
+
+// Push-style walk: one loop over the data with its own small stack of open
+// containers instead of the push/pop/elementRead bookkeeping per value
+template<std::endian Order>
+Result<void> BasicNBTReader<Order>::tryVisit(Visitor& visitor)
+{
+    if (!isOpen) {
+        return fail(ErrorCode::NotOpen);
+    }
+    if (!isInCompound()) {
+        return fail(ErrorCode::NotInCompound);
+    }
+
+    struct Frame
+    {
+        bool isCompound;
+        char elementType;
+        int remaining;
+    };
+    std::vector<Frame> frames;
+    frames.reserve(16);
+    frames.push_back({true, idEnd, 0});
+    // Gzip windows move on refill, so names are copied before the payload
+    std::string nameCopy;
+    TagValue value{};
+
+    while (!frames.empty()) {
+        Frame& frame = frames.back();
+        char type;
+        std::string_view name;
+        if (frame.isCompound) {
+            auto tag = tryReadTagType();
+            if (!tag) {
+                return std::unexpected(tag.error());
             }
-            break;
+            if (*tag == idEnd) {
+                frames.pop_back();
+                if (!frames.empty()) {
+                    visitor.onCompoundEnd();
+                }
+                continue;
+            }
+            auto tagName = tryReadTagNameView();
+            if (!tagName) {
+                return std::unexpected(tagName.error());
+            }
+            type = *tag;
+            name = *tagName;
+            if (Inflate) {
+                nameCopy.assign(name);
+                name = nameCopy;
+            }
+        } else {
+            if (frame.remaining == 0) {
+                frames.pop_back();
+                visitor.onListEnd();
+                continue;
+            }
+            frame.remaining--;
+            type = frame.elementType;
         }
-        case idCompound: {
-            while (true) {
-                char type = readTagType();
-                if (type == idEnd) break;
-                std::string name = readTagName();
-                skipTag(type);
+
+        value.type = type;
+        switch(type) {
+            case idByte:
+            case idShort:
+            case idInt:
+            case idLong: {
+                Result<long long> integer;
+                if (type == idByte) {
+                    integer = readValue<char>();
+                } else if (type == idShort) {
+                    integer = readValue<short>();
+                } else if (type == idInt) {
+                    integer = readValue<int>();
+                } else {
+                    integer = readValue<long long>();
+                }
+                if (!integer) {
+                    return std::unexpected(integer.error());
+                }
+                value.integer = *integer;
+                visitor.onTag(name, value);
+                break;
             }
-            break;
+            case idFloat: {
+                auto real = readValue<float>();
+                if (!real) {
+                    return std::unexpected(real.error());
+                }
+                value.real = *real;
+                visitor.onTag(name, value);
+                break;
+            }
+            case idDouble: {
+                auto real = readValue<double>();
+                if (!real) {
+                    return std::unexpected(real.error());
+                }
+                value.real = *real;
+                visitor.onTag(name, value);
+                break;
+            }
+            case idString: {
+                auto text = tryReadStringPayloadView();
+                if (!text) {
+                    return std::unexpected(text.error());
+                }
+                value.bytes = *text;
+                visitor.onTag(name, value);
+                break;
+            }
+            case idByteArray:
+            case idIntArray:
+            case idLongArray: {
+                size_t width = type == idByteArray ? 1 : type == idIntArray ? 4 : 8;
+                auto count = readValue<int>();
+                if (!count) {
+                    return std::unexpected(count.error());
+                }
+                if (*count < 0) {
+                    return fail(ErrorCode::NegativeLength);
+                }
+                size_t length = static_cast<size_t>(*count) * width;
+                if (auto ok = require(length); !ok) {
+                    return ok;
+                }
+                value.bytes = std::string_view(Cursor, length);
+                value.count = *count;
+                Cursor += length;
+                visitor.onTag(name, value);
+                break;
+            }
+            case idCompound:
+                if (frames.size() >= VisitDepthLimit) {
+                    return fail(ErrorCode::TooDeep);
+                }
+                if (visitor.onCompoundBegin(name)) {
+                    frames.push_back({true, idEnd, 0});
+                } else if (auto ok = trySkipTag(idCompound); !ok) {
+                    return ok;
+                }
+                break;
+            case idList: {
+                auto elementType = readValue<char>();
+                if (!elementType) {
+                    return std::unexpected(elementType.error());
+                }
+                auto count = readValue<int>();
+                if (!count) {
+                    return std::unexpected(count.error());
+                }
+                if (*count < 0) {
+                    return fail(ErrorCode::NegativeLength);
+                }
+                if (frames.size() >= VisitDepthLimit) {
+                    return fail(ErrorCode::TooDeep);
+                }
+                if (visitor.onListBegin(name, *elementType, *count)) {
+                    frames.push_back({false, *elementType, *count});
+                } else if (auto ok = skipListElements(*elementType, *count); !ok) {
+                    return ok;
+                }
+                break;
+            }
+            default:
+                return fail(ErrorCode::UnknownTagType);
         }
-        default:
-            throw std::runtime_error("Unknown tag type in skipTag");
     }
+
+    // The loop consumed the current compound's TAG_End
+    pop();
+    elementRead();
+    return {};
 }
 
-void NBTReader::skipCurrentTag()
+template<std::endian Order>
+void BasicNBTReader<Order>::visit(Visitor& visitor)
 {
-    if (isInCompound()) {
-        char type = readTagType();
-        std::string name = readTagName();
-        skipTag(type);
-    } else if (isInList()) {
-        skipTag(readType());
-        elementRead();
+    unwrap(tryVisit(visitor));
+}
+
+// Structure-only walk: every type byte, length and bound is checked, but
+// names and strings are stepped over rather than viewed or copied
+template<std::endian Order>
+Result<void> BasicNBTReader<Order>::tryValidate()
+{
+    if (!isOpen) {
+        return fail(ErrorCode::NotOpen);
+    }
+    if (!isInCompound()) {
+        return fail(ErrorCode::NotInCompound);
+    }
+
+    struct Frame
+    {
+        bool isCompound;
+        char elementType;
+        int remaining;
+    };
+    std::vector<Frame> frames;
+    frames.reserve(16);
+    frames.push_back({true, idEnd, 0});
+
+    while (!frames.empty()) {
+        Frame& frame = frames.back();
+        char type;
+        if (frame.isCompound) {
+            auto tag = tryReadTagType();
+            if (!tag) {
+                return std::unexpected(tag.error());
+            }
+            if (*tag == idEnd) {
+                frames.pop_back();
+                continue;
+            }
+            if (*tag < idEnd || *tag > idLongArray) {
+                // Report the type byte itself
+                Cursor--;
+                return fail(ErrorCode::UnknownTagType);
+            }
+            auto nameLength = readLength16();
+            if (!nameLength) {
+                return std::unexpected(nameLength.error());
+            }
+            if (auto ok = advance(*nameLength); !ok) {
+                return ok;
+            }
+            type = *tag;
+        } else {
+            if (frame.remaining == 0) {
+                frames.pop_back();
+                continue;
+            }
+            frame.remaining--;
+            type = frame.elementType;
+        }
+
+        if (long long width = fixedTagWidth(type); width != 0) {
+            if (auto ok = advance(width); !ok) {
+                return ok;
+            }
+            continue;
+        }
+        switch(type) {
+            case idString: {
+                auto length = readLength16();
+                if (!length) {
+                    return std::unexpected(length.error());
+                }
+                if (auto ok = advance(*length); !ok) {
+                    return ok;
+                }
+                break;
+            }
+            case idByteArray:
+            case idIntArray:
+            case idLongArray: {
+                long long width = type == idByteArray ? 1 : type == idIntArray ? 4 : 8;
+                auto count = readValue<int>();
+                if (!count) {
+                    return std::unexpected(count.error());
+                }
+                if (auto ok = advance(*count * width); !ok) {
+                    return ok;
+                }
+                break;
+            }
+            case idCompound:
+                if (frames.size() >= VisitDepthLimit) {
+                    return fail(ErrorCode::TooDeep);
+                }
+                frames.push_back({true, idEnd, 0});
+                break;
+            case idList: {
+                auto elementType = readValue<char>();
+                if (!elementType) {
+                    return std::unexpected(elementType.error());
+                }
+                if (*elementType < idEnd || *elementType > idLongArray) {
+                    Cursor--;
+                    return fail(ErrorCode::UnknownTagType);
+                }
+                auto count = readValue<int>();
+                if (!count) {
+                    return std::unexpected(count.error());
+                }
+                if (*count < 0) {
+                    return fail(ErrorCode::NegativeLength);
+                }
+                if (*count == 0) {
+                    break;
+                }
+                // Only empty lists may have TAG_End elements
+                if (*elementType == idEnd) {
+                    return fail(ErrorCode::UnknownTagType);
+                }
+                if (long long width = fixedTagWidth(*elementType); width != 0) {
+                    if (auto ok = advance(*count * width); !ok) {
+                        return ok;
+                    }
+                    break;
+                }
+                if (frames.size() >= VisitDepthLimit) {
+                    return fail(ErrorCode::TooDeep);
+                }
+                frames.push_back({false, *elementType, *count});
+                break;
+            }
+            default:
+                return fail(ErrorCode::UnknownTagType);
+        }
     }
+
+    // The loop consumed the current compound's TAG_End
+    pop();
+    elementRead();
+    return {};
+}
+
+template<std::endian Order>
+void BasicNBTReader<Order>::validate()
+{
+    unwrap(tryValidate());
+}
+
+template<std::endian Order>
+Result<void> BasicNBTReader<Order>::trySeekCompound(unsigned long long offset)
+{
+    if (!isOpen) {
+        return fail(ErrorCode::NotOpen);
+    }
+    if (Inflate) {
+        return fail(ErrorCode::NotSeekable);
+    }
+    if (offset > static_cast<unsigned long long>(End-Begin)) {
+        return fail(ErrorCode::UnexpectedEof);
+    }
+    Cursor = Begin + offset;
+    Stack.clear();
+    push(idEnd, 0);
+    return {};
+}
+
+template<std::endian Order>
+void BasicNBTReader<Order>::seekCompound(unsigned long long offset)
+{
+    unwrap(trySeekCompound(offset));
 }
 
 // Enter compound
-void NBTReader::enterCompound(const char* expectedName)
+template<std::endian Order>
+Result<void> BasicNBTReader<Order>::tryEnterCompound(const char* expectedName)
 {
     if (isInCompound() && expectedName != nullptr) {
-        char type = readTagType();
-        if (type != idCompound) {
-            throw std::runtime_error("Expected COMPOUND tag");
-        }
-
-        std::string name = readTagName();
-        if (name != expectedName) {
-            throw std::runtime_error(
-                std::string("Expected tag name '") + expectedName +
-                "' but got '" + name + "'"
-            );
+        if (auto ok = matchTagHeader(idCompound, expectedName); !ok) {
+            return ok;
         }
     } else if (isInList() && typeMatch(idCompound)) {
         // In list, no header to read
     }
 
     push(idEnd, 0);
+    return {};
+}
+
+template<std::endian Order>
+void BasicNBTReader<Order>::enterCompound(const char* expectedName)
+{
+    unwrap(tryEnterCompound(expectedName));
 }
 
 // Exit compound (read TAG_END)
-void NBTReader::exitCompound()
+template<std::endian Order>
+Result<void> BasicNBTReader<Order>::tryExitCompound()
 {
     if (!isInCompound()) {
-        throw std::runtime_error("Not in compound");
+        return fail(ErrorCode::NotInCompound);
     }
 
-    char endTag = readTagType();
-    if (endTag != idEnd) {
-        throw std::runtime_error("Expected TAG_END");
+    auto endTag = tryReadTagType();
+    if (!endTag) {
+        return std::unexpected(endTag.error());
+    }
+    if (*endTag != idEnd) {
+        return fail(ErrorCode::MissingEnd);
     }
 
     pop();
     elementRead();
+    return {};
+}
+
+template<std::endian Order>
+void BasicNBTReader<Order>::exitCompound()
+{
+    unwrap(tryExitCompound());
 }
 
 // Read list header
-void NBTReader::readListHead(const char* expectedName, char* outElementType, int* outSize)
+template<std::endian Order>
+Result<void> BasicNBTReader<Order>::tryReadListHead(const char* expectedName, char* outElementType, int* outSize)
 {
     if (isInCompound()) {
-        char type = readTagType();
-        if (type != idList) {
-            throw std::runtime_error("Expected LIST tag");
-        }
-
-        std::string name = readTagName();
-        if (expectedName != nullptr && name != expectedName) {
-            throw std::runtime_error(
-                std::string("Expected tag name '") + expectedName +
-                "' but got '" + name + "'"
-            );
+        if (auto ok = matchTagHeader(idList, expectedName); !ok) {
+            return ok;
         }
     } else if (isInList() && typeMatch(idList)) {
         // List within list
     }
 
-    char elementType = readValue<char>();
-    int size = readValue<int>();
+    auto elementType = readValue<char>();
+    if (!elementType) {
+        return std::unexpected(elementType.error());
+    }
+    auto size = readValue<int>();
+    if (!size) {
+        return std::unexpected(size.error());
+    }
+    if (*size < 0) {
+        return fail(ErrorCode::NegativeLength);
+    }
 
-    *outElementType = elementType;
-    *outSize = size;
+    *outElementType = *elementType;
+    *outSize = *size;
 
-    push(elementType, size);
-    if (size == 0) {
+    // Empty lists are not pushed: a TAG_End one would look like a compound
+    if (*size > 0) {
+        push(*elementType, *size);
+    } else {
         elementRead();
     }
+    return {};
 }
 
-// Read primitive tags
-char NBTReader::readByte(const char* expectedName)
+template<std::endian Order>
+void BasicNBTReader<Order>::readListHead(const char* expectedName, char* outElementType, int* outSize)
 {
-    if (isInCompound()) {
-        char type = readTagType();
-        if (type != idByte) {
-            throw std::runtime_error("Expected BYTE tag");
-        }
+    unwrap(tryReadListHead(expectedName, outElementType, outSize));
+}
 
-        std::string name = readTagName();
-        if (expectedName != nullptr && name != expectedName) {
-            throw std::runtime_error(
-                std::string("Expected tag name '") + expectedName +
-                "' but got '" + name + "'"
-            );
-        }
-    } else if (isInList()) {
-        if (!typeMatch(idByte)) {
-            throw std::runtime_error("Type mismatch in list");
+// Read a primitive tag: header in a compound, bare payload in a list
+template<std::endian Order>
+template<typename T>
+Result<T> BasicNBTReader<Order>::tryReadSingle(char typeId, const char* expectedName)
+{
+    if (isInCompound()) {
+        if (auto ok = matchTagHeader(typeId, expectedName); !ok) {
+            return std::unexpected(ok.error());
         }
+    } else if (!typeMatch(typeId)) {
+        return fail(ErrorCode::ListTypeMismatch);
     }
 
-    char value = readValue<char>();
-    elementRead();
+    Result<T> value;
+    if constexpr (std::is_same_v<T, std::string_view>) {
+        value = tryReadStringPayloadView();
+    } else {
+        value = readValue<T>();
+    }
+    if (value) {
+        elementRead();
+    }
     return value;
 }
 
-short NBTReader::readShort(const char* expectedName)
+template<std::endian Order>
+Result<char> BasicNBTReader<Order>::tryReadByte(const char* expectedName)
 {
-    if (isInCompound()) {
-        char type = readTagType();
-        if (type != idShort) {
-            throw std::runtime_error("Expected SHORT tag");
-        }
+    return tryReadSingle<char>(idByte, expectedName);
+}
 
-        std::string name = readTagName();
-        if (expectedName != nullptr && name != expectedName) {
-            throw std::runtime_error(
-                std::string("Expected tag name '") + expectedName +
-                "' but got '" + name + "'"
-            );
-        }
-    } else if (isInList()) {
-        if (!typeMatch(idShort)) {
-            throw std::runtime_error("Type mismatch in list");
-        }
-    }
+template<std::endian Order>
+Result<short> BasicNBTReader<Order>::tryReadShort(const char* expectedName)
+{
+    return tryReadSingle<short>(idShort, expectedName);
+}
 
-    short value = readValue<short>();
-    elementRead();
-    return value;
+template<std::endian Order>
+Result<int> BasicNBTReader<Order>::tryReadInt(const char* expectedName)
+{
+    return tryReadSingle<int>(idInt, expectedName);
 }
 
-int NBTReader::readInt(const char* expectedName)
+template<std::endian Order>
+Result<long long> BasicNBTReader<Order>::tryReadLong(const char* expectedName)
 {
-    if (isInCompound()) {
-        char type = readTagType();
-        if (type != idInt) {
-            throw std::runtime_error("Expected INT tag");
-        }
+    return tryReadSingle<long long>(idLong, expectedName);
+}
 
-        std::string name = readTagName();
-        if (expectedName != nullptr && name != expectedName) {
-            throw std::runtime_error(
-                std::string("Expected tag name '") + expectedName +
-                "' but got '" + name + "'"
-            );
-        }
-    } else if (isInList()) {
-        if (!typeMatch(idInt)) {
-            throw std::runtime_error("Type mismatch in list");
-        }
-    }
+template<std::endian Order>
+Result<float> BasicNBTReader<Order>::tryReadFloat(const char* expectedName)
+{
+    return tryReadSingle<float>(idFloat, expectedName);
+}
 
-    int value = readValue<int>();
-    elementRead();
-    return value;
+template<std::endian Order>
+Result<double> BasicNBTReader<Order>::tryReadDouble(const char* expectedName)
+{
+    return tryReadSingle<double>(idDouble, expectedName);
 }
 
-long long NBTReader::readLong(const char* expectedName)
+// Read string without copying; the view points into the mapped input
+template<std::endian Order>
+Result<std::string_view> BasicNBTReader<Order>::tryReadStringView(const char* expectedName)
 {
-    if (isInCompound()) {
-        char type = readTagType();
-        if (type != idLong) {
-            throw std::runtime_error("Expected LONG tag");
-        }
+    return tryReadSingle<std::string_view>(idString, expectedName);
+}
 
-        std::string name = readTagName();
-        if (expectedName != nullptr && name != expectedName) {
-            throw std::runtime_error(
-                std::string("Expected tag name '") + expectedName +
-                "' but got '" + name + "'"
-            );
-        }
-    } else if (isInList()) {
-        if (!typeMatch(idLong)) {
-            throw std::runtime_error("Type mismatch in list");
-        }
-    }
+template<std::endian Order>
+char BasicNBTReader<Order>::readByte(const char* expectedName)
+{
+    return unwrap(tryReadByte(expectedName));
+}
 
-    long long value = readValue<long long>();
-    elementRead();
-    return value;
+template<std::endian Order>
+short BasicNBTReader<Order>::readShort(const char* expectedName)
+{
+    return unwrap(tryReadShort(expectedName));
 }
 
-float NBTReader::readFloat(const char* expectedName)
+template<std::endian Order>
+int BasicNBTReader<Order>::readInt(const char* expectedName)
 {
-    if (isInCompound()) {
-        char type = readTagType();
-        if (type != idFloat) {
-            throw std::runtime_error("Expected FLOAT tag");
-        }
+    return unwrap(tryReadInt(expectedName));
+}
 
-        std::string name = readTagName();
-        if (expectedName != nullptr && name != expectedName) {
-            throw std::runtime_error(
-                std::string("Expected tag name '") + expectedName +
-                "' but got '" + name + "'"
-            );
-        }
-    } else if (isInList()) {
-        if (!typeMatch(idFloat)) {
-            throw std::runtime_error("Type mismatch in list");
-        }
-    }
+template<std::endian Order>
+long long BasicNBTReader<Order>::readLong(const char* expectedName)
+{
+    return unwrap(tryReadLong(expectedName));
+}
 
-    float value = readValue<float>();
-    elementRead();
-    return value;
+template<std::endian Order>
+float BasicNBTReader<Order>::readFloat(const char* expectedName)
+{
+    return unwrap(tryReadFloat(expectedName));
 }
 
-double NBTReader::readDouble(const char* expectedName)
+template<std::endian Order>
+double BasicNBTReader<Order>::readDouble(const char* expectedName)
 {
-    if (isInCompound()) {
-        char type = readTagType();
-        if (type != idDouble) {
-            throw std::runtime_error("Expected DOUBLE tag");
-        }
+    return unwrap(tryReadDouble(expectedName));
+}
 
-        std::string name = readTagName();
-        if (expectedName != nullptr && name != expectedName) {
-            throw std::runtime_error(
-                std::string("Expected tag name '") + expectedName +
-                "' but got '" + name + "'"
-            );
-        }
-    } else if (isInList()) {
-        if (!typeMatch(idDouble)) {
-            throw std::runtime_error("Type mismatch in list");
-        }
-    }
+template<std::endian Order>
+std::string BasicNBTReader<Order>::readString(const char* expectedName)
+{
+    return std::string(readStringView(expectedName));
+}
 
-    double value = readValue<double>();
-    elementRead();
-    return value;
+template<std::endian Order>
+std::string_view BasicNBTReader<Order>::readStringView(const char* expectedName)
+{
+    return unwrap(tryReadStringView(expectedName));
 }
 
-// Read string
-std::string NBTReader::readString(const char* expectedName)
+// Read array heads; elements are then read as a list of elementType
+template<std::endian Order>
+Result<int> BasicNBTReader<Order>::tryReadArrayHead(char arrayType, char elementType, const char* expectedName)
 {
     if (isInCompound()) {
-        char type = readTagType();
-        if (type != idString) {
-            throw std::runtime_error("Expected STRING tag");
+        if (auto ok = matchTagHeader(arrayType, expectedName); !ok) {
+            return std::unexpected(ok.error());
         }
+    }
 
-        std::string name = readTagName();
-        if (expectedName != nullptr && name != expectedName) {
-            throw std::runtime_error(
-                std::string("Expected tag name '") + expectedName +
-                "' but got '" + name + "'"
-            );
-        }
-    } else if (isInList()) {
-        if (!typeMatch(idString)) {
-            throw std::runtime_error("Type mismatch in list");
-        }
+    auto arraySize = readValue<int>();
+    if (!arraySize) {
+        return arraySize;
+    }
+    if (*arraySize < 0) {
+        return fail(ErrorCode::NegativeLength);
+    }
+    push(elementType, *arraySize);
+    if (*arraySize == 0) {
+        elementRead();
     }
+    return arraySize;
+}
 
-    short length = readValue<short>();
-    std::string result(length, '\0');
-    File->read(&result[0], length);
-    ByteCount += length;
+template<std::endian Order>
+Result<int> BasicNBTReader<Order>::tryReadByteArrayHead(const char* expectedName)
+{
+    return tryReadArrayHead(idByteArray, idByte, expectedName);
+}
 
-    if (File->eof() || File->fail()) {
-        throw std::runtime_error("Unexpected EOF while reading string");
-    }
+template<std::endian Order>
+Result<int> BasicNBTReader<Order>::tryReadIntArrayHead(const char* expectedName)
+{
+    return tryReadArrayHead(idIntArray, idInt, expectedName);
+}
 
-    elementRead();
-    return result;
+template<std::endian Order>
+Result<int> BasicNBTReader<Order>::tryReadLongArrayHead(const char* expectedName)
+{
+    return tryReadArrayHead(idLongArray, idLong, expectedName);
 }
 
-// Read array heads
-int NBTReader::readByteArrayHead(const char* expectedName)
+template<std::endian Order>
+int BasicNBTReader<Order>::readByteArrayHead(const char* expectedName)
 {
-    if (isInCompound()) {
-        char type = readTagType();
-        if (type != idByteArray) {
-            throw std::runtime_error("Expected BYTE_ARRAY tag");
-        }
+    return unwrap(tryReadByteArrayHead(expectedName));
+}
 
-        std::string name = readTagName();
-        if (expectedName != nullptr && name != expectedName) {
-            throw std::runtime_error(
-                std::string("Expected tag name '") + expectedName +
-                "' but got '" + name + "'"
-            );
-        }
+template<std::endian Order>
+int BasicNBTReader<Order>::readIntArrayHead(const char* expectedName)
+{
+    return unwrap(tryReadIntArrayHead(expectedName));
+}
+
+template<std::endian Order>
+int BasicNBTReader<Order>::readLongArrayHead(const char* expectedName)
+{
+    return unwrap(tryReadLongArrayHead(expectedName));
+}
+
+// Bulk read: copy count elements of the current array or list at once and
+// swap them to host order together
+template<std::endian Order>
+Result<void> BasicNBTReader<Order>::tryReadArrayPayload(char elementType, void* out, size_t count, size_t width)
+{
+    if (count == 0) {
+        return {};
+    }
+    if (isInCompound() || !typeMatch(elementType)) {
+        return fail(ErrorCode::ListTypeMismatch);
+    }
+    if (count > static_cast<size_t>(readSize())) {
+        return fail(ErrorCode::ArrayOverrun);
+    }
+    if (auto ok = copyOut(static_cast<char*>(out), count * width); !ok) {
+        return ok;
     }
 
-    int arraySize = readValue<int>();
-    push(idByte, arraySize);
-    if (arraySize == 0) {
-        elementRead();
+    if constexpr (NeedsSwap) {
+        IE2BEArray(out, count, width);
     }
-    return arraySize;
+
+    Stack.size() -= static_cast<int>(count);
+    endList();
+    return {};
 }
 
-int NBTReader::readIntArrayHead(const char* expectedName)
+template<std::endian Order>
+Result<void> BasicNBTReader<Order>::tryReadByteArray(std::span<char> out)
 {
-    if (isInCompound()) {
-        char type = readTagType();
-        if (type != idIntArray) {
-            throw std::runtime_error("Expected INT_ARRAY tag");
-        }
+    return tryReadArrayPayload(idByte, out.data(), out.size(), 1);
+}
 
-        std::string name = readTagName();
-        if (expectedName != nullptr && name != expectedName) {
-            throw std::runtime_error(
-                std::string("Expected tag name '") + expectedName +
-                "' but got '" + name + "'"
-            );
-        }
-    }
+template<std::endian Order>
+Result<void> BasicNBTReader<Order>::tryReadIntArray(std::span<int> out)
+{
+    return tryReadArrayPayload(idInt, out.data(), out.size(), sizeof(int));
+}
 
-    int arraySize = readValue<int>();
-    push(idInt, arraySize);
-    if (arraySize == 0) {
-        elementRead();
-    }
-    return arraySize;
+template<std::endian Order>
+Result<void> BasicNBTReader<Order>::tryReadLongArray(std::span<long long> out)
+{
+    return tryReadArrayPayload(idLong, out.data(), out.size(), sizeof(long long));
 }
 
-int NBTReader::readLongArrayHead(const char* expectedName)
+template<std::endian Order>
+void BasicNBTReader<Order>::readByteArray(std::span<char> out)
 {
-    if (isInCompound()) {
-        char type = readTagType();
-        if (type != idLongArray) {
-            throw std::runtime_error("Expected LONG_ARRAY tag");
-        }
+    unwrap(tryReadByteArray(out));
+}
 
-        std::string name = readTagName();
-        if (expectedName != nullptr && name != expectedName) {
-            throw std::runtime_error(
-                std::string("Expected tag name '") + expectedName +
-                "' but got '" + name + "'"
-            );
-        }
-    }
+template<std::endian Order>
+void BasicNBTReader<Order>::readIntArray(std::span<int> out)
+{
+    unwrap(tryReadIntArray(out));
+}
 
-    int arraySize = readValue<int>();
-    push(idLong, arraySize);
-    if (arraySize == 0) {
-        elementRead();
-    }
-    return arraySize;
+template<std::endian Order>
+void BasicNBTReader<Order>::readLongArray(std::span<long long> out)
+{
+    unwrap(tryReadLongArray(out));
 }
 
+template class NBT::BasicNBTReader<std::endian::big>;
+template class NBT::BasicNBTReader<std::endian::little>;
+
 #endif
@@ -25,122 +25,309 @@ This file is part of SlopeCraft.
 #define _NBTWriter_Cpp
 #include "NBTWriter.h"
 #include <iostream>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define NBT_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
 
 using namespace NBT;
 
-bool NBT::isSysBE()
+TwinStack::TwinStack(const TwinStack&other)
+    :TwinStack()
+{
+    *this=other;
+}
+
+TwinStack&TwinStack::operator=(const TwinStack&other)
+{
+    if(this==&other)return *this;
+    Top=-1;
+    while(Capacity<other.depth())grow();
+    std::copy(other.Levels,other.Levels+other.depth(),Levels);
+    Top=other.Top;
+    return *this;
+}
+
+void TwinStack::grow()
+{
+    std::unique_ptr<Level[]> bigger(new Level[Capacity*2]);
+    std::copy(Levels,Levels+Top+1,bigger.get());
+    Heap=std::move(bigger);
+    Levels=Heap.get();
+    Capacity*=2;
+}
+
+template<typename T>
+static void IE2BEArrayScalar(char*data,size_t count)
+{
+    for(size_t i=0;i<count;i++)
+    {
+        T value;
+        std::memcpy(&value,data+i*sizeof(T),sizeof(T));
+        value=std::byteswap(value);
+        std::memcpy(data+i*sizeof(T),&value,sizeof(T));
+    }
+}
+
+#ifdef NBT_X86
+// Swap whole 16-byte blocks with one shuffle each; returns the bytes done
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("ssse3")))
+#endif
+static size_t IE2BEArraySSSE3(char*data,size_t bytes,size_t width)
+{
+    const __m128i order=
+        width==2?_mm_setr_epi8(1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14):
+        width==4?_mm_setr_epi8(3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12):
+                 _mm_setr_epi8(7,6,5,4,3,2,1,0,15,14,13,12,11,10,9,8);
+    size_t done=0;
+    for(;done+16<=bytes;done+=16)
+    {
+        __m128i block=_mm_loadu_si128(reinterpret_cast<const __m128i*>(data+done));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data+done),_mm_shuffle_epi8(block,order));
+    }
+    return done;
+}
+
+static bool cpuHasSSSE3()
 {
-    short S=1;char *temp=(char*)&S;
-    if(temp[0]==0&&temp[1]==1)
-    return true;
-    return false;
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info,1);
+    return (info[2]&(1<<9))!=0;
+#else
+    return __builtin_cpu_supports("ssse3");
+#endif
 }
+#endif
 
-NBTWriter::NBTWriter(const char*path)
+void NBT::IE2BEArray(void*data,size_t count,size_t width)
+{
+    char*bytes=static_cast<char*>(data);
+#ifdef NBT_X86
+    static const bool useSSSE3=cpuHasSSSE3();
+    if(useSSSE3&&width>1)
+    {
+        size_t done=IE2BEArraySSSE3(bytes,count*width,width);
+        bytes+=done;
+        count-=done/width;
+    }
+#endif
+    switch(width)
+    {
+        case 2:IE2BEArrayScalar<std::uint16_t>(bytes,count);break;
+        case 4:IE2BEArrayScalar<std::uint32_t>(bytes,count);break;
+        case 8:IE2BEArrayScalar<std::uint64_t>(bytes,count);break;
+        default:break;
+    }
+}
+
+// Hand everything buffered so far to the file in one write
+template<std::endian Order>
+void BasicNBTWriter<Order>::flush()
+{
+    if(Buffer.empty())return;
+    if(Compressor)
+    {
+        Packed.clear();
+        Compressor->write(Buffer.data(),Buffer.size(),Packed);
+        emit(Packed.data(),Packed.size());
+    }
+    else
+    emit(Buffer.data(),Buffer.size());
+    Buffer.clear();
+}
+
+template<std::endian Order>
+void BasicNBTWriter<Order>::emit(const char*data,size_t length)
+{
+    if(length==0)return;
+    if(Sink!=NULL)
+    {
+        const std::byte*bytes=reinterpret_cast<const std::byte*>(data);
+        Sink->insert(Sink->end(),bytes,bytes+length);
+    }
+    else
+    File->write(data,length);
+}
+
+// All tag bytes go through here; they reach the file in WriterBlockSize blocks
+template<std::endian Order>
+inline void BasicNBTWriter<Order>::put(const char*data,size_t length)
+{
+    Buffer.insert(Buffer.end(),data,data+length);
+    if(Buffer.size()>=WriterBlockSize)flush();
+}
+
+template<std::endian Order>
+BasicNBTWriter<Order>::BasicNBTWriter(const char*path)
 {
     allowEmergencyFill=true;
-    isBE=isSysBE();
     ByteCount=0;
+    HeaderAt=-1;
     File=new std::fstream(path,std::ios::out|std::ios::binary);
+    Sink=NULL;
+    Buffer.reserve(WriterBlockSize);
         char temp[3]={10,0,0};
-        File->write(temp,3);ByteCount+=3;
+        put(temp,3);ByteCount+=3;
     isOpen=true;
-    for(top=0;top<TwinStackSize;top++)
-    {
-        CLA[top]=114;
-        Size[top]=114514;
-    }
 
-    top=-1;
+}
+
+template<std::endian Order>
+BasicNBTWriter<Order>::BasicNBTWriter(std::vector<std::byte>&sink)
+{
+    allowEmergencyFill=true;
+    ByteCount=0;
+    HeaderAt=-1;
+    File=NULL;
+    Sink=&sink;
+    Buffer.reserve(WriterBlockSize);
+        char temp[3]={10,0,0};
+        put(temp,3);ByteCount+=3;
+    isOpen=true;
 
 }
 
-NBTWriter::NBTWriter()
+template<std::endian Order>
+BasicNBTWriter<Order>::BasicNBTWriter()
 {
     allowEmergencyFill=true;
-    isBE=isSysBE();
     ByteCount=0;
+    HeaderAt=-1;
+    Sink=NULL;
     File=NULL;//new fstream(path,ios::out|ios::binary);
         //char temp[3]={10,0,0};
         //File->write(temp,3);ByteCount+=3;
     isOpen=false;
-    for(top=0;top<TwinStackSize;top++)
-    {
-        CLA[top]=114;
-        Size[top]=114514;
-    }
-
-    top=-1;
 
 }
 
-void NBTWriter::open(const char*path)
+template<std::endian Order>
+void BasicNBTWriter<Order>::open(const char*path)
 {
     if(isOpen)
     {
         return;
     }
     File=new std::fstream(path,std::ios::out|std::ios::binary);
+    Buffer.reserve(WriterBlockSize);
     char temp[3]={10,0,0};
-    File->write(temp,3);ByteCount+=3;
+    put(temp,3);ByteCount+=3;
     isOpen=true;
 }
 
 
-NBTWriter::~NBTWriter()
+template<std::endian Order>
+BasicNBTWriter<Order>::~BasicNBTWriter()
 {
     if(isOpen)close();
     delete File;
     return;
 }
 
-unsigned long long NBTWriter::close()
+template<std::endian Order>
+unsigned long long BasicNBTWriter<Order>::close()
 {
     if(isOpen)
     {
         if(!isEmpty())emergencyFill();
 
-    File->write(&idEnd,1);ByteCount+=1;
-    File->close();}
+    put(&idEnd,1);ByteCount+=1;
+    flush();
+    if(Compressor)
+    {
+        Packed.clear();
+        Compressor->finish(Packed);
+        emit(Packed.data(),Packed.size());
+    }
+    if(HeaderAt>=0)patchBedrockHeader();
+    if(File!=NULL)File->close();
+    isOpen=false;}
     return ByteCount;
 }
 
-bool NBTWriter::isEmpty()
+// Bedrock level.dat framing: int32 storage version and int32 payload length
+// in front of the root compound. Only valid before the first tag.
+template<std::endian Order>
+void BasicNBTWriter<Order>::writeBedrockHeader(int storageVersion)
+{
+    if(!isOpen||ByteCount!=3||HeaderAt>=0||Compressor)return;
+    int header[2]={storageVersion,0};
+    if constexpr(NeedsSwap)IE2BE(header[0]);
+    Buffer.insert(Buffer.begin(),(char*)header,(char*)header+8);
+    ByteCount+=8;
+    HeaderAt=(Sink!=NULL)?Sink->size():0;
+}
+
+// Nothing has been flushed yet, so every byte goes through the compressor
+template<std::endian Order>
+void BasicNBTWriter<Order>::setCompression(int level)
+{
+    if(!isOpen||ByteCount!=3||HeaderAt>=0)return;
+    Compressor=std::make_unique<Deflater>(level);
+}
+
+// The payload length is only known at close, after the data was flushed
+template<std::endian Order>
+void BasicNBTWriter<Order>::patchBedrockHeader()
 {
-    return (top==-1);
+    int payloadLength=ByteCount-8;
+    if constexpr(NeedsSwap)IE2BE(payloadLength);
+    if(Sink!=NULL)
+    {
+        std::memcpy(Sink->data()+HeaderAt+4,&payloadLength,4);
+        return;
+    }
+    File->seekp(HeaderAt+4);
+    File->write((char*)&payloadLength,4);
 }
 
-bool NBTWriter::isFull()
+template<std::endian Order>
+bool BasicNBTWriter<Order>::isEmpty()
 {
-    return top>=TwinStackSize;
+    return Stack.empty();
 }
 
-bool NBTWriter::isListFinished()
+template<std::endian Order>
+bool BasicNBTWriter<Order>::isListFinished()
 {
-    return (Size[top]<=0);
+    return (Stack.size()<=0);
 }
 
-char NBTWriter::readType()
+template<std::endian Order>
+char BasicNBTWriter<Order>::readType()
 {
-    return CLA[top];
+    return Stack.type();
 }
 
-bool NBTWriter::isInCompound()
+template<std::endian Order>
+bool BasicNBTWriter<Order>::isInCompound()
 {
     return isEmpty()||(readType()==0);
 }
 
-bool NBTWriter::isInList()
+template<std::endian Order>
+bool BasicNBTWriter<Order>::isInList()
 {
     return !isInCompound();
 }
 
-bool NBTWriter::typeMatch(char typeId)
+template<std::endian Order>
+bool BasicNBTWriter<Order>::typeMatch(char typeId)
 {
     return(readType()==typeId);
 }
 
-void NBTWriter::endList()
+template<std::endian Order>
+void BasicNBTWriter<Order>::endList()
 {
     if(isInList()&&isListFinished())
     {
@@ -150,65 +337,57 @@ void NBTWriter::endList()
     return;
 }
 
-void NBTWriter::pop()
+template<std::endian Order>
+void BasicNBTWriter<Order>::pop()
 {
-    if(!isEmpty()){
-    top--;
-    }
-    else
-        ;
-    return;
+    Stack.pop();
 }
 
-void NBTWriter::push(char typeId,int size)
+template<std::endian Order>
+void BasicNBTWriter<Order>::push(char typeId,int size)
 {
-    if(!isFull())
-    {
-        top++;
-        CLA[top]=typeId;
-        Size[top]=size;
-        //qDebug()<<"push成功，栈顶CLA="<<(short)CLA[top]<<"，Size="<<Size[top];
-    }
-    else
-    return;
+    Stack.push(typeId,size);
 }
 
-void NBTWriter:: elementWritten()
+template<std::endian Order>
+void BasicNBTWriter<Order>::elementWritten()
 {
     if(isInList()&&!isListFinished())
-    Size[top]--;
+    Stack.size()--;
     if(isListFinished())
     endList();
     return;
 }
 
-int NBTWriter::writeEnd()
+template<std::endian Order>
+int BasicNBTWriter<Order>::writeEnd()
 {
-    File->write(&idEnd,1);
+    put(&idEnd,1);
     return 1;
 }
 
+template<std::endian Order>
 template <typename T>
-int NBTWriter::writeSingleTag(char typeId,const char*Name,T value)
+int BasicNBTWriter<Order>::writeSingleTag(char typeId,const char*Name,T value)
 {
     int ThisCount=0;short realNameL=strlen(Name),writeNameL=realNameL;
-    if(!isBE)
+    if constexpr(NeedsSwap)
     {
         IE2BE(writeNameL);IE2BE(value);//value不需要读取，只需要写入
     }
     if (isInCompound())//写入为完整的Tag
     {
         //qDebug()<<"写入为文件夹内的id"<<(short)typeId;
-        File->write(&typeId,sizeof(char));ThisCount+=sizeof(char);
-        File->write((char*)&writeNameL,sizeof(short));ThisCount+=sizeof(short);
-        File->write(Name,realNameL);ThisCount+=realNameL;
-        File->write((char*)&value,sizeof(T));ThisCount+=sizeof(T);
+        put(&typeId,sizeof(char));ThisCount+=sizeof(char);
+        put((char*)&writeNameL,sizeof(short));ThisCount+=sizeof(short);
+        put(Name,realNameL);ThisCount+=realNameL;
+        put((char*)&value,sizeof(T));ThisCount+=sizeof(T);
     }
 
     if (isInList()&&typeMatch(typeId))//写入为列表中的tag
     {
         //qDebug()<<"写入为列表中的id"<<(short)typeId;
-        File->write((char*)&value,sizeof(T));ThisCount+=sizeof(T);
+        put((char*)&value,sizeof(T));ThisCount+=sizeof(T);
         elementWritten();
 
     }
@@ -218,26 +397,27 @@ int NBTWriter::writeSingleTag(char typeId,const char*Name,T value)
 
 
 
-int NBTWriter::writeLongDirectly(const char*Name,long long value)
+template<std::endian Order>
+int BasicNBTWriter<Order>::writeLongDirectly(const char*Name,long long value)
 {
     int ThisCount=0;short realNameL=strlen(Name),writeNameL=realNameL;
-    if(!isBE)
+    if constexpr(NeedsSwap)
     {
         IE2BE(writeNameL);//value不需要读取，只需要写入
     }
     if (isInCompound())//写入为完整的Tag
     {
         //qDebug()<<"写入为文件夹内的id"<<(short)NBT::idLong;
-        File->write(&NBT::idLong,sizeof(char));ThisCount+=sizeof(char);
-        File->write((char*)&writeNameL,sizeof(short));ThisCount+=sizeof(short);
-        File->write(Name,realNameL);ThisCount+=realNameL;
-        File->write((char*)&value,sizeof(long long));ThisCount+=sizeof(long long);
+        put(&NBT::idLong,sizeof(char));ThisCount+=sizeof(char);
+        put((char*)&writeNameL,sizeof(short));ThisCount+=sizeof(short);
+        put(Name,realNameL);ThisCount+=realNameL;
+        put((char*)&value,sizeof(long long));ThisCount+=sizeof(long long);
     }
 
     if (isInList()&&typeMatch(NBT::idLong))//写入为列表中的tag
     {
         //qDebug()<<"写入为列表中的id"<<(short)NBT::idLong;
-        File->write((char*)&value,sizeof(long long));ThisCount+=sizeof(long long);
+        put((char*)&value,sizeof(long long));ThisCount+=sizeof(long long);
         elementWritten();
 
     }
@@ -246,19 +426,20 @@ int NBTWriter::writeLongDirectly(const char*Name,long long value)
 }
 
 
-int NBTWriter::writeCompound(const char*Name)
+template<std::endian Order>
+int BasicNBTWriter<Order>::writeCompound(const char*Name)
 {
     if (!isOpen)return 0;
     int ThisCount=0;short realNameL=strlen(Name),writeNameL=realNameL;
-    if(!isBE)
+    if constexpr(NeedsSwap)
     {
         IE2BE(writeNameL);
     }
     if(isInCompound())
     {
-        File->write(&idCompound,sizeof(char));ThisCount+=sizeof(char);
-        File->write((char*)&writeNameL,sizeof(short));ThisCount+=sizeof(short);
-        File->write(Name,realNameL);ThisCount+=realNameL;
+        put(&idCompound,sizeof(char));ThisCount+=sizeof(char);
+        put((char*)&writeNameL,sizeof(short));ThisCount+=sizeof(short);
+        put(Name,realNameL);ThisCount+=realNameL;
         push(idEnd,0);
         ByteCount+=ThisCount;
         return ThisCount;
@@ -277,7 +458,8 @@ int NBTWriter::writeCompound(const char*Name)
 
 }
 
-int NBTWriter::endCompound()
+template<std::endian Order>
+int BasicNBTWriter<Order>::endCompound()
 {
     if(!isOpen)return 0;
     int ThisCount=0;
@@ -292,81 +474,91 @@ int NBTWriter::endCompound()
     return ThisCount;
 }
 
-int NBTWriter::writeListHead(const char*Name,char TypeId,int listSize)
+template<std::endian Order>
+int BasicNBTWriter<Order>::writeListHead(const char*Name,char TypeId,int listSize)
 {
     int ThisCount=0;short realNameL=strlen(Name),writeNameL=realNameL;
     int writeListSize=listSize;//listSize->readListSize
-    if(!isBE){IE2BE(writeNameL);IE2BE(writeListSize);}
+    if constexpr(NeedsSwap){IE2BE(writeNameL);IE2BE(writeListSize);}
 
     if(isInCompound())
     {
-        File->write(&idList,sizeof(char));ThisCount+=sizeof(char);
-        File->write((char*)&writeNameL,sizeof(short));ThisCount+=sizeof(short);
-        File->write(Name,realNameL);ThisCount+=realNameL;
-        File->write(&TypeId,sizeof(char));ThisCount+=sizeof(char);
-        File->write((char*)&writeListSize,sizeof(int));ThisCount+=sizeof(int);
-        push(TypeId,listSize);
+        put(&idList,sizeof(char));ThisCount+=sizeof(char);
+        put((char*)&writeNameL,sizeof(short));ThisCount+=sizeof(short);
+        put(Name,realNameL);ThisCount+=realNameL;
+        put(&TypeId,sizeof(char));ThisCount+=sizeof(char);
+        put((char*)&writeListSize,sizeof(int));ThisCount+=sizeof(int);
+        //An empty list has nothing to track, and one of TAG_End would look
+        //like a compound on the stack
+        if(listSize>0)push(TypeId,listSize);else elementWritten();
         ByteCount+=ThisCount;
-        if(listSize==0)elementWritten();
         return ThisCount;
     }
 
     if(isInList()&&typeMatch(idList))
     {
-        File->write(&TypeId,sizeof(char));ThisCount+=sizeof(char);
-        File->write((char*)&writeListSize,sizeof(int));ThisCount+=sizeof(int);
-        push(TypeId,listSize);
+        put(&TypeId,sizeof(char));ThisCount+=sizeof(char);
+        put((char*)&writeListSize,sizeof(int));ThisCount+=sizeof(int);
+        //An empty list has nothing to track, and one of TAG_End would look
+        //like a compound on the stack
+        if(listSize>0)push(TypeId,listSize);else elementWritten();
         ByteCount+=ThisCount;
-        if(listSize==0)elementWritten();
         return ThisCount;
     }
     return ThisCount;
 
 }
 
-int NBTWriter::writeByte(const char*Name,char value)
+template<std::endian Order>
+int BasicNBTWriter<Order>::writeByte(const char*Name,char value)
 {
     return writeSingleTag(idByte,Name,value);
 }
 
-int NBTWriter::writeShort(const char*Name,short value)
+template<std::endian Order>
+int BasicNBTWriter<Order>::writeShort(const char*Name,short value)
 {
     return writeSingleTag(idShort,Name,value);
 }
 
-int NBTWriter::writeInt(const char*Name,int value)
+template<std::endian Order>
+int BasicNBTWriter<Order>::writeInt(const char*Name,int value)
 {
     return writeSingleTag(idInt,Name,value);
 }
 
-int NBTWriter::writeLong(const char*Name,long long value)
+template<std::endian Order>
+int BasicNBTWriter<Order>::writeLong(const char*Name,long long value)
 {
     return writeSingleTag(idLong,Name,value);
 }
 
-int NBTWriter::writeFloat(const char*Name,float value)
+template<std::endian Order>
+int BasicNBTWriter<Order>::writeFloat(const char*Name,float value)
 {
     return writeSingleTag(idFloat,Name,value);
 }
 
-int NBTWriter::writeDouble(const char*Name,double value)
+template<std::endian Order>
+int BasicNBTWriter<Order>::writeDouble(const char*Name,double value)
 {
     return writeSingleTag(idDouble,Name,value);
 }
 
-int NBTWriter::writeLongArrayHead(const char*Name,int arraySize)
+template<std::endian Order>
+int BasicNBTWriter<Order>::writeLongArrayHead(const char*Name,int arraySize)
 {
     int ThisCount=0;short realNameL=strlen(Name),writeNameL=realNameL;
     int writeArraySize=arraySize;//arraSize->readArraySize
-    if(!isBE){IE2BE(writeNameL);IE2BE(writeArraySize);}
+    if constexpr(NeedsSwap){IE2BE(writeNameL);IE2BE(writeArraySize);}
 
     if(isInCompound())
     {
-        File->write(&idLongArray,sizeof(char));ThisCount+=sizeof(char);
-        File->write((char*)&writeNameL,sizeof(short));ThisCount+=sizeof(short);
-        File->write(Name,realNameL);ThisCount+=realNameL;
+        put(&idLongArray,sizeof(char));ThisCount+=sizeof(char);
+        put((char*)&writeNameL,sizeof(short));ThisCount+=sizeof(short);
+        put(Name,realNameL);ThisCount+=realNameL;
         //File->write(&idLong,sizeof(char));ThisCount+=sizeof(char);
-        File->write((char*)&writeArraySize,sizeof(int));ThisCount+=sizeof(int);
+        put((char*)&writeArraySize,sizeof(int));ThisCount+=sizeof(int);
         push(idLong,arraySize);
         ByteCount+=ThisCount;
         if(arraySize==0)elementWritten();
@@ -376,7 +568,7 @@ int NBTWriter::writeLongArrayHead(const char*Name,int arraySize)
     if(isInList()&&typeMatch(idLongArray))
     {
         //File->write(&idLong,sizeof(char));ThisCount+=sizeof(char);
-        File->write((char*)&writeArraySize,sizeof(int));ThisCount+=sizeof(int);
+        put((char*)&writeArraySize,sizeof(int));ThisCount+=sizeof(int);
         push(idLong,arraySize);
         ByteCount+=ThisCount;
         if(arraySize==0)elementWritten();
@@ -385,19 +577,20 @@ int NBTWriter::writeLongArrayHead(const char*Name,int arraySize)
     return ThisCount;
 }
 
-int NBTWriter::writeByteArrayHead(const char*Name,int arraySize)
+template<std::endian Order>
+int BasicNBTWriter<Order>::writeByteArrayHead(const char*Name,int arraySize)
 {
     int ThisCount=0;short realNameL=strlen(Name),writeNameL=realNameL;
     int writeArraySize=arraySize;//arraSize->readArraySize
-    if(!isBE){IE2BE(writeNameL);IE2BE(writeArraySize);}
+    if constexpr(NeedsSwap){IE2BE(writeNameL);IE2BE(writeArraySize);}
 
     if(isInCompound())
     {
-        File->write(&idByteArray,sizeof(char));ThisCount+=sizeof(char);
-        File->write((char*)&writeNameL,sizeof(short));ThisCount+=sizeof(short);
-        File->write(Name,realNameL);ThisCount+=realNameL;
+        put(&idByteArray,sizeof(char));ThisCount+=sizeof(char);
+        put((char*)&writeNameL,sizeof(short));ThisCount+=sizeof(short);
+        put(Name,realNameL);ThisCount+=realNameL;
         //File->write(&idLong,sizeof(char));ThisCount+=sizeof(char);
-        File->write((char*)&writeArraySize,sizeof(int));ThisCount+=sizeof(int);
+        put((char*)&writeArraySize,sizeof(int));ThisCount+=sizeof(int);
         push(idByte,arraySize);
         ByteCount+=ThisCount;
         if(arraySize==0)elementWritten();
@@ -407,7 +600,7 @@ int NBTWriter::writeByteArrayHead(const char*Name,int arraySize)
     if(isInList()&&typeMatch(idByteArray))
     {
         //File->write(&idLong,sizeof(char));ThisCount+=sizeof(char);
-        File->write((char*)&writeArraySize,sizeof(int));ThisCount+=sizeof(int);
+        put((char*)&writeArraySize,sizeof(int));ThisCount+=sizeof(int);
         push(idByte,arraySize);
         ByteCount+=ThisCount;
         if(arraySize==0)elementWritten();
@@ -416,19 +609,20 @@ int NBTWriter::writeByteArrayHead(const char*Name,int arraySize)
     return ThisCount;
 }
 
-int NBTWriter::writeIntArrayHead(const char*Name,int arraySize)
+template<std::endian Order>
+int BasicNBTWriter<Order>::writeIntArrayHead(const char*Name,int arraySize)
 {
     int ThisCount=0;short realNameL=strlen(Name),writeNameL=realNameL;
     int writeArraySize=arraySize;//arraySize->readArraySize
-    if(!isBE){IE2BE(writeNameL);IE2BE(writeArraySize);}
+    if constexpr(NeedsSwap){IE2BE(writeNameL);IE2BE(writeArraySize);}
 
     if(isInCompound())
     {
-        File->write(&idIntArray,sizeof(char));ThisCount+=sizeof(char);
-        File->write((char*)&writeNameL,sizeof(short));ThisCount+=sizeof(short);
-        File->write(Name,realNameL);ThisCount+=realNameL;
+        put(&idIntArray,sizeof(char));ThisCount+=sizeof(char);
+        put((char*)&writeNameL,sizeof(short));ThisCount+=sizeof(short);
+        put(Name,realNameL);ThisCount+=realNameL;
 
-        File->write((char*)&writeArraySize,sizeof(int));ThisCount+=sizeof(int);
+        put((char*)&writeArraySize,sizeof(int));ThisCount+=sizeof(int);
         push(idInt,arraySize);
         ByteCount+=ThisCount;
         if(arraySize==0)elementWritten();
@@ -438,7 +632,7 @@ int NBTWriter::writeIntArrayHead(const char*Name,int arraySize)
     if(isInList()&&typeMatch(idIntArray))
     {
         //File->write(&idLong,sizeof(char));ThisCount+=sizeof(char);
-        File->write((char*)&writeArraySize,sizeof(int));ThisCount+=sizeof(int);
+        put((char*)&writeArraySize,sizeof(int));ThisCount+=sizeof(int);
         push(idInt,arraySize);
         ByteCount+=ThisCount;
         if(arraySize==0)elementWritten();
@@ -447,20 +641,74 @@ int NBTWriter::writeIntArrayHead(const char*Name,int arraySize)
     return ThisCount;
 }
 
-int NBTWriter::writeString(const char*Name,const char*value)
+// Copy array elements straight into the block buffer and swap them there,
+// one block at a time, then close the pseudo-list the head pushed
+template<std::endian Order>
+int BasicNBTWriter<Order>::putArrayPayload(const void*data,size_t count,size_t width)
+{
+    const char*src=static_cast<const char*>(data);
+    size_t remaining=count*width;
+    while(remaining>0)
+    {
+        size_t chunk=std::min(remaining,(size_t)WriterBlockSize/width*width);
+        size_t old=Buffer.size();
+        Buffer.resize(old+chunk);
+        std::memcpy(Buffer.data()+old,src,chunk);
+        if constexpr(NeedsSwap)IE2BEArray(Buffer.data()+old,chunk/width,width);
+        src+=chunk;remaining-=chunk;
+        if(Buffer.size()>=WriterBlockSize)flush();
+    }
+    ByteCount+=count*width;
+    if(count>0){Stack.size()=0;endList();}
+    return count*width;
+}
+
+template<std::endian Order>
+int BasicNBTWriter<Order>::writeByteArray(const char*Name,std::span<const char> values)
 {
+    int ThisCount=writeByteArrayHead(Name,values.size());
+    if(ThisCount==0)return 0;
+    return ThisCount+putArrayPayload(values.data(),values.size(),1);
+}
+
+template<std::endian Order>
+int BasicNBTWriter<Order>::writeIntArray(const char*Name,std::span<const int> values)
+{
+    int ThisCount=writeIntArrayHead(Name,values.size());
+    if(ThisCount==0)return 0;
+    return ThisCount+putArrayPayload(values.data(),values.size(),sizeof(int));
+}
+
+template<std::endian Order>
+int BasicNBTWriter<Order>::writeLongArray(const char*Name,std::span<const long long> values)
+{
+    int ThisCount=writeLongArrayHead(Name,values.size());
+    if(ThisCount==0)return 0;
+    return ThisCount+putArrayPayload(values.data(),values.size(),sizeof(long long));
+}
+
+template<std::endian Order>
+int BasicNBTWriter<Order>::writeString(const char*Name,const char*value)
+{
+    return writeString(Name,std::string_view(value));
+}
+
+template<std::endian Order>
+int BasicNBTWriter<Order>::writeString(const char*Name,std::string_view value)
+{
+    if(value.size()>0xFFFF)return 0;
     int ThisCount=0;
     short realNameL=strlen(Name),writeNameL=realNameL;
-    short realValL=strlen(value),writeValL=realValL;
-    if(!isBE){IE2BE(writeNameL);IE2BE(writeValL);}
+    unsigned short realValL=value.size(),writeValL=realValL;
+    if constexpr(NeedsSwap){IE2BE(writeNameL);IE2BE(writeValL);}
 
     if(isInCompound())
     {
-        File->write(&idString,sizeof(char));ThisCount+=sizeof(char);
-        File->write((char*)&writeNameL,sizeof(short));ThisCount+=sizeof(short);
-        File->write(Name,realNameL);ThisCount+=realNameL;
-        File->write((char*)&writeValL,sizeof(short));ThisCount+=sizeof(short);
-        File->write(value,realValL);ThisCount+=realValL;
+        put(&idString,sizeof(char));ThisCount+=sizeof(char);
+        put((char*)&writeNameL,sizeof(short));ThisCount+=sizeof(short);
+        put(Name,realNameL);ThisCount+=realNameL;
+        put((char*)&writeValL,sizeof(short));ThisCount+=sizeof(short);
+        put(value.data(),realValL);ThisCount+=realValL;
         ByteCount+=ThisCount;
         elementWritten();
         return ThisCount;
@@ -468,8 +716,8 @@ int NBTWriter::writeString(const char*Name,const char*value)
 
     if(isInList()&&typeMatch(idString))
     {
-        File->write((char*)&writeValL,sizeof(short));ThisCount+=sizeof(short);
-        File->write(value,realValL);ThisCount+=realValL;
+        put((char*)&writeValL,sizeof(short));ThisCount+=sizeof(short);
+        put(value.data(),realValL);ThisCount+=realValL;
         ByteCount+=ThisCount;
         elementWritten();
         return ThisCount;
@@ -477,12 +725,14 @@ int NBTWriter::writeString(const char*Name,const char*value)
     return ThisCount;
 }
 
-char NBTWriter::CurrentType()
+template<std::endian Order>
+char BasicNBTWriter<Order>::CurrentType()
 {
     return readType();
 }
 
-int NBTWriter::emergencyFill()
+template<std::endian Order>
+int BasicNBTWriter<Order>::emergencyFill()
 {
     if(!allowEmergencyFill)return 0;
     if(isEmpty())return 0;
@@ -537,9 +787,13 @@ int NBTWriter::emergencyFill()
     ThisCount+=writeString("TokiNoBug'sWarning","There's sth wrong with ur NBTWriter, the file format is completed automatically instead of manually.");
     return ThisCount;
 }
-unsigned long long NBTWriter::getByteCount()
+template<std::endian Order>
+unsigned long long BasicNBTWriter<Order>::getByteCount()
 {
     return ByteCount;
 }
 
+template class NBT::BasicNBTWriter<std::endian::big>;
+template class NBT::BasicNBTWriter<std::endian::little>;
+
 #endif
@@ -0,0 +1,128 @@
+#include "csv_scan.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define ENBT_CSV_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define ENBT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define ENBT_TARGET_AVX2
+#endif
+
+csv_block_masks scan_csv_block_scalar(const char* block) {
+	csv_block_masks masks{0, 0};
+	for (int i = 0; i < 64; ++i) {
+		const char c = block[i];
+		const std::uint64_t bit = std::uint64_t{1} << i;
+		if (c == ',' || c == '|' || c == ';') {
+			masks.delims |= bit;
+		} else if (c == '\n') {
+			masks.newlines |= bit;
+		}
+	}
+	return masks;
+}
+
+#ifdef ENBT_CSV_X86
+static csv_block_masks scan_csv_block_sse2(const char* block) {
+	const __m128i comma = _mm_set1_epi8(',');
+	const __m128i pipe = _mm_set1_epi8('|');
+	const __m128i semicolon = _mm_set1_epi8(';');
+	const __m128i newline = _mm_set1_epi8('\n');
+
+	csv_block_masks masks{0, 0};
+	for (int i = 0; i < 4; ++i) {
+		const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i * 16));
+		const __m128i delims = _mm_or_si128(_mm_or_si128(
+			_mm_cmpeq_epi8(bytes, comma),
+			_mm_cmpeq_epi8(bytes, pipe)),
+			_mm_cmpeq_epi8(bytes, semicolon));
+		const std::uint64_t delim_bits = static_cast<std::uint32_t>(_mm_movemask_epi8(delims));
+		const std::uint64_t newline_bits = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)));
+		masks.delims |= delim_bits << (i * 16);
+		masks.newlines |= newline_bits << (i * 16);
+	}
+	return masks;
+}
+
+ENBT_TARGET_AVX2
+static csv_block_masks scan_csv_block_avx2(const char* block) {
+	const __m256i comma = _mm256_set1_epi8(',');
+	const __m256i pipe = _mm256_set1_epi8('|');
+	const __m256i semicolon = _mm256_set1_epi8(';');
+	const __m256i newline = _mm256_set1_epi8('\n');
+
+	csv_block_masks masks{0, 0};
+	for (int i = 0; i < 2; ++i) {
+		const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i * 32));
+		const __m256i delims = _mm256_or_si256(_mm256_or_si256(
+			_mm256_cmpeq_epi8(bytes, comma),
+			_mm256_cmpeq_epi8(bytes, pipe)),
+			_mm256_cmpeq_epi8(bytes, semicolon));
+		const std::uint64_t delim_bits = static_cast<std::uint32_t>(_mm256_movemask_epi8(delims));
+		const std::uint64_t newline_bits = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, newline)));
+		masks.delims |= delim_bits << (i * 32);
+		masks.newlines |= newline_bits << (i * 32);
+	}
+	return masks;
+}
+
+static bool cpu_has_avx2() {
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return false;
+	}
+	__cpuid(info, 1);
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) {
+		return false;
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+using scan_fn = csv_block_masks (*)(const char*);
+
+static scan_fn select_scan(const char** name) {
+#ifdef ENBT_CSV_X86
+	if (cpu_has_avx2()) {
+		*name = "avx2";
+		return scan_csv_block_avx2;
+	}
+	*name = "sse2";
+	return scan_csv_block_sse2;
+#else
+	*name = "scalar";
+	return scan_csv_block_scalar;
+#endif
+}
+
+struct scan_dispatch {
+	const char* name = "scalar";
+	scan_fn impl = select_scan(&name);
+};
+
+// resolved on first use so callers running during static init are safe
+static const scan_dispatch& dispatch() {
+	static const scan_dispatch selected{};
+	return selected;
+}
+
+csv_block_masks scan_csv_block(const char* block) {
+	return dispatch().impl(block);
+}
+
+const char* csv_scan_backend() {
+	return dispatch().name;
+}
@@ -4,6 +4,8 @@
 #include <fstream>
 #include <sstream>
 #include <filesystem>
+#include <optional>
+#include <stdexcept>
 #include "parse.hpp"
 #include "serialize.hpp"
 #include "NBTWriter.h"
@@ -25,9 +27,14 @@ void usage(const std::string_view program) {
 	std::cout << "\t-t <csv|toml|json>\t\tSpecifies the type of input/output file\n";
 	std::cout << "\t-o <output_path>\t\tSpecifies the output path\n";
 	std::cout << "\t-r, --reverse\t\t\tReverse mode: convert servers.dat to CSV/JSON/TOML\n";
+	std::cout << "\t-c, --compact\t\t\tReverse mode: write JSON without indentation\n";
+	std::cout << "\t-b, --bedrock\t\t\tUse Bedrock little-endian NBT with a level.dat header\n";
+	std::cout << "\t-z <0-9>\t\t\tgzip the servers.dat at this level (gzip input is always detected)\n";
+	std::cout << "\t--check\t\t\t\tOnly check that the input NBT file is well-formed\n";
 	std::cout << "\nExamples:\n";
 	std::cout << "  Forward:  " << program << " -i servers.csv -o servers.dat\n";
 	std::cout << "  Reverse:  " << program << " -r -i servers.dat -t csv -o servers.csv\n";
+	std::cout << "  Check:    " << program << " --check -i servers.dat\n";
 }
 
 void parse_arg(const std::string_view cmd, 
@@ -47,7 +54,10 @@ void parse_arg(const std::string_view cmd,
 }
 
 
-void ips_to_dat(std::istream* ip_stream, const std::string_view output_path, const std::string_view format) {
+// Storage version written into the Bedrock level.dat header
+constexpr int bedrock_storage_version = 10;
+
+void ips_to_dat(std::istream* ip_stream, const std::string_view output_path, const std::string_view format, const nbt_flavor flavor, const int compression) {
 	fs::path output_fs_path = output_path;
 	if (output_fs_path.empty()) {
 		std::cout << "Output path is empty\n";
@@ -77,65 +87,88 @@ void ips_to_dat(std::istream* ip_stream, const std::string_view output_path, con
 		exit(1);
 	}
 
-	NBT::NBTWriter writer(output_fs_path.string().data());
-	writer.writeListHead("servers", NBT::idCompound, servers.size());
-	for (const nbtserver& server : servers) {	
-		#if 0
-		std::cout << server.name << '\n';
-		std::cout << server.icon << '\n';
-		std::cout << server.ip << '\n';
-		std::cout << server.accept_textures << '\n';
-		std::cout << "------------------\n"; 
-		#endif
-	 	writer.writeCompound("");
-		writer.writeString("name", server.name.data());
-		writer.writeString("icon", server.icon.data());
-		writer.writeString("ip", server.ip.data());
-		writer.writeByte("acceptTextures", server.accept_textures);
+	// Same tag sequence for both editions; only the writer's byte order differs
+	const auto write_servers = [&](auto& writer) {
+		writer.writeListHead("servers", NBT::idCompound, servers.size());
+		for (const nbtserver& server : servers) {	
+			#if 0
+			std::cout << server.name << '\n';
+			std::cout << server.icon << '\n';
+			std::cout << server.ip << '\n';
+			std::cout << server.accept_textures << '\n';
+			std::cout << "------------------\n"; 
+			#endif
+		 	writer.writeCompound("");
+			writer.writeString("name", server.name.data());
+			writer.writeString("icon", server.icon.data());
+			writer.writeString("ip", server.ip.data());
+			writer.writeByte("acceptTextures", server.accept_textures);
+			writer.endCompound();
+		}
 		writer.endCompound();
+		writer.close();
+	};
+
+	if (flavor == nbt_flavor::bedrock) {
+		NBT::NBTWriterLE writer(output_fs_path.string().data());
+		writer.writeBedrockHeader(bedrock_storage_version);
+		write_servers(writer);
+	} else {
+		NBT::NBTWriter writer(output_fs_path.string().data());
+		if (compression >= 0) {
+			writer.setCompression(compression);
+		}
+		write_servers(writer);
 	}
-	writer.endCompound();
-	writer.close();
 }
 
 void dat_to_format(const std::string_view input_path,
 				   const std::string_view output_path,
-				   const std::string_view format) {
+				   const std::string_view format,
+				   const json_layout layout,
+				   const nbt_flavor flavor) {
 
-	const std::vector<nbtserver> servers = parse_servers_dat(std::string(input_path));
+	// Servers are serialized as they are decoded, so only one is in memory
+	// at a time. The output is opened on the first server so an empty list
+	// leaves no file behind.
+	std::ofstream out;
+	std::optional<server_serializer> serializer;
+	const auto open_output = [&]() -> std::ostream& {
+		if (output_path == "-") {
+			return std::cout;
+		}
+		std::string output_path_str{output_path};
+		out.open(output_path_str);
+		if (!out.is_open()) {
+			std::cerr << "Unable to open output file for writing (" << output_path << ")\n";
+			exit(1);
+		}
+		return out;
+	};
 
-	if (servers.empty()) {
-		std::cout << "No servers found in " << input_path << "\n";
+	bool read_ok = false;
+	try {
+		read_ok = read_servers_dat(std::string(input_path), [&](nbtserver&& server) {
+			if (!serializer) {
+				serializer.emplace(open_output(), format, layout);
+			}
+			serializer->write(server);
+		}, flavor);
+	} catch (const std::invalid_argument& e) {
+		// JSON output of a string that isn't UTF-8
+		std::cerr << "Output is incomplete: " << input_path << " can't be written as " << format << " (" << e.what() << ")\n";
 		exit(1);
 	}
 
-	const std::string output_content = [&]() {
-		if (format == "csv")
-			return serialize_servers_csv(servers);
-		else if (format == "toml")
-			return serialize_servers_toml(servers);
-		else if (format == "json")
-			return serialize_servers_json(servers);
-		return std::string{};
-	}();
-
-	if (output_content.empty()) {
-		std::cout << "Failed to serialize servers\n";
+	if (!serializer) {
+		std::cerr << "No servers found in " << input_path << "\n";
 		exit(1);
 	}
 
-	// Write to file or stdout
-	if (output_path == "-") {
-		std::cout << output_content;
-	} else {
-		std::string output_path_str{output_path};
-		std::ofstream out{output_path_str};
-		if (!out.is_open()) {
-			std::cout << "Unable to open output file for writing (" << output_path << ")\n";
-			exit(1);
-		}
-		out << output_content;
-		out.close();
+	serializer->finish();
+	if (!read_ok) {
+		std::cerr << "Output is incomplete: " << input_path << " could not be read to the end\n";
+		exit(1);
 	}
 }
 
@@ -149,6 +182,10 @@ int main(int argc, char** argv) {
 	std::string input_type = "csv";
 	bool explicit_extension = false;
 	bool reverse_mode = false;
+	bool check_mode = false;
+	json_layout layout = json_layout::pretty;
+	nbt_flavor flavor = nbt_flavor::java;
+	std::string compression_arg{};
 
 	while (argc > 0) {
 		const std::string_view cmd = argv[0];
@@ -161,6 +198,14 @@ int main(int argc, char** argv) {
 			explicit_extension = true;
 		} else if (cmd == "-r" || cmd == "--reverse") {
 			reverse_mode = true;
+		} else if (cmd == "-c" || cmd == "--compact") {
+			layout = json_layout::compact;
+		} else if (cmd == "--check") {
+			check_mode = true;
+		} else if (cmd == "-b" || cmd == "--bedrock") {
+			flavor = nbt_flavor::bedrock;
+		} else if (cmd == "-z") {
+			parse_arg(cmd, compression_arg, "", &argc, &argv, true);
 		} else {
 			std::cout << "unknown option '" << cmd << "'\n";
 			usage(program);
@@ -182,6 +227,23 @@ int main(int argc, char** argv) {
 		exit(1);
 	}
 
+	if (check_mode) {
+		return check_servers_dat(input_path, flavor) ? 0 : 1;
+	}
+
+	int compression = -1;
+	if (!compression_arg.empty()) {
+		if (compression_arg.size() != 1 || compression_arg[0] < '0' || compression_arg[0] > '9') {
+			std::cout << "Invalid value for -z '" << compression_arg << "' (expected 0-9)\n";
+			exit(1);
+		}
+		if (flavor == nbt_flavor::bedrock) {
+			std::cout << "-z can't be combined with --bedrock\n";
+			exit(1);
+		}
+		compression = compression_arg[0] - '0';
+	}
+
 	// Handle reverse mode vs forward mode
 	if (reverse_mode) {
 		// servers.dat -> CSV/JSON/TOML
@@ -195,7 +257,7 @@ int main(int argc, char** argv) {
 			exit(1);
 		}
 
-		dat_to_format(input_path, output_path, input_type);
+		dat_to_format(input_path, output_path, input_type, layout, flavor);
 	} else {
 		// CSV/JSON/TOML -> servers.dat (existing code)
 		std::ifstream ip_file_stream;
@@ -224,7 +286,7 @@ int main(int argc, char** argv) {
 			exit(1);
 		}
 
-		ips_to_dat(ip_stream, output_path, input_type);
+		ips_to_dat(ip_stream, output_path, input_type, flavor, compression);
 	}
 
 	return 0;
@@ -1,50 +1,411 @@
 #include "parse.hpp"
+#include "csv_scan.hpp"
 #include "toml.hpp"
 #include "nlohmann/json.hpp"
 #include "NBTReader.h"
+#include "server_index.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <thread>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <iostream>
 #include <filesystem>
 
+// SAX handler that validates the document and collects nbtserver records in
+// the same pass, without building a DOM. Only the top level "servers" array
+// is decoded; everything else is skipped by depth.
+struct servers_json_handler {
+	using json = nlohmann::json;
+
+	enum field : unsigned char { icon = 1, ip = 2, name = 4, accept_textures = 8, other = 0 };
+	static constexpr unsigned char all_fields = icon | ip | name | accept_textures;
+
+	std::vector<nbtserver> servers{};
+	size_t skipped = 0;
+	bool has_servers_array = false;
+
+	std::size_t depth = 0;
+	bool next_is_servers = false;	// the top level "servers" key was just read
+	std::size_t array_depth = 0;	// depth of the servers array, 0 when outside it
+	std::size_t entry_depth = 0;	// depth of the current server object, 0 when outside one
+	field current = other;
+	unsigned char seen = 0;
+	nbtserver entry{};
+
+	// any value (scalar or container) starting at the current position
+	void on_value(bool is_object) {
+		if (next_is_servers) {
+			next_is_servers = false;
+			has_servers_array = false;
+		}
+		if (entry_depth == 0 && array_depth != 0 && depth == array_depth && !is_object) {
+			++skipped;	// a servers element that is not an object
+		}
+	}
+
+	bool null() { on_value(false); return true; }
+	bool number_integer(json::number_integer_t) { on_value(false); return true; }
+	bool number_unsigned(json::number_unsigned_t) { on_value(false); return true; }
+	bool number_float(json::number_float_t, const json::string_t&) { on_value(false); return true; }
+	bool binary(json::binary_t&) { on_value(false); return true; }
+
+	bool boolean(bool val) {
+		on_value(false);
+		if (entry_depth != 0 && depth == entry_depth && current == accept_textures) {
+			entry.accept_textures = val;
+			seen |= accept_textures;
+		}
+		return true;
+	}
+
+	bool string(json::string_t& val) {
+		on_value(false);
+		if (entry_depth == 0 || depth != entry_depth) {
+			return true;
+		}
+		switch (current) {
+		case icon: entry.icon = std::move(val); break;
+		case ip: entry.ip = std::move(val); break;
+		case name: entry.name = std::move(val); break;
+		default: return true;
+		}
+		seen |= current;
+		return true;
+	}
+
+	bool start_object(std::size_t) {
+		const bool starts_entry = entry_depth == 0 && array_depth != 0 && depth == array_depth;
+		on_value(true);
+		++depth;
+		if (starts_entry) {
+			entry_depth = depth;
+			entry = nbtserver{};
+			seen = 0;
+			current = other;
+		}
+		return true;
+	}
+
+	bool key(json::string_t& val) {
+		if (depth == 1) {
+			next_is_servers = val == "servers";
+			if (next_is_servers) {
+				// a repeated key replaces the earlier value, as in the DOM
+				servers.clear();
+				skipped = 0;
+			}
+		} else if (depth == entry_depth) {
+			current = val == "icon" ? icon
+				: val == "ip" ? ip
+				: val == "name" ? name
+				: val == "accept_textures" ? accept_textures
+				: other;
+			seen &= static_cast<unsigned char>(~current);
+		}
+		return true;
+	}
+
+	bool end_object() {
+		if (depth == entry_depth) {
+			if (seen == all_fields) {
+				servers.emplace_back(std::move(entry));
+			} else {
+				++skipped;
+			}
+			entry_depth = 0;
+		}
+		--depth;
+		return true;
+	}
+
+	bool start_array(std::size_t) {
+		const bool starts_servers = next_is_servers;
+		on_value(false);
+		++depth;
+		if (starts_servers) {
+			has_servers_array = true;
+			array_depth = depth;
+		}
+		return true;
+	}
+
+	bool end_array() {
+		if (depth == array_depth) {
+			array_depth = 0;
+		}
+		--depth;
+		return true;
+	}
+
+	bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) {
+		return false;
+	}
+};
+
 std::vector<nbtserver> parse_servers_json(const std::string& content) {
 	using json = nlohmann::json;
 	if (content.empty()) {
 		std::cout << "json file content is empty. no servers.dat created\n";
 		return {};
 	}
-	
-	if (!json::accept(content)) {
+
+	servers_json_handler handler{};
+	if (!json::sax_parse(content, &handler)) {
 		// TODO show where its malformed/show error from nlohmann json?
 		std::cout << "json is malformed. validate the syntax and try again\n";
 		return {};
 	}
 
-	json config = json::parse(content);
-	if (!config.contains("servers") || !config["servers"].is_array()) {
+	if (!handler.has_servers_array) {
 		std::cout << "json is malformed. requires a 'servers' array\n";
 		return {};
 	}
 
+	for (size_t i = 0; i < handler.skipped; ++i) {
+		std::cout << "warning: a server entry is missing required fields. it will not be added to the servers list\n";
+	}
+
+	return std::move(handler.servers);
+}
+
+// Fast path for the layout serialize_servers_toml writes: [[servers]]
+// headers followed by icon/ip/name strings and an accept_textures boolean,
+// with blank lines and comments in between. Anything else (other keys,
+// inline tables, multi-line strings, duplicates, ...) yields std::nullopt
+// and the caller falls back to toml11.
+struct toml_fast_result {
 	std::vector<nbtserver> servers{};
-    	servers.reserve(config["servers"].size());
+	std::size_t skipped = 0;
+};
 
-	for (const auto& server : config["servers"]) {
-		if (!server.contains("icon") || !server.contains("ip") || 
-			!server.contains("name") || !server.contains("accept_textures")) {
-			std::cout << "warning: a server entry is missing required fields. it will not be added to the servers list\n";
+static std::string_view toml_skip_ws(std::string_view text) {
+	std::size_t i = 0;
+	while (i < text.size() && (text[i] == ' ' || text[i] == '\t')) {
+		++i;
+	}
+	return text.substr(i);
+}
+
+// only whitespace and an optional comment may follow a value or header
+static bool toml_line_done(std::string_view rest) {
+	rest = toml_skip_ws(rest);
+	return rest.empty() || rest[0] == '#';
+}
+
+static bool toml_append_utf8(std::string& out, std::uint32_t cp) {
+	if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+		return false;
+	}
+	if (cp < 0x80) {
+		out += static_cast<char>(cp);
+	} else if (cp < 0x800) {
+		out += static_cast<char>(0xC0 | (cp >> 6));
+		out += static_cast<char>(0x80 | (cp & 0x3F));
+	} else if (cp < 0x10000) {
+		out += static_cast<char>(0xE0 | (cp >> 12));
+		out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+		out += static_cast<char>(0x80 | (cp & 0x3F));
+	} else {
+		out += static_cast<char>(0xF0 | (cp >> 18));
+		out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+		out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+		out += static_cast<char>(0x80 | (cp & 0x3F));
+	}
+	return true;
+}
+
+// Decode a single-line basic or literal string at the start of text into
+// out; rest receives what follows the closing quote
+static bool toml_read_string(std::string_view text, std::string& out, std::string_view& rest) {
+	if (text.starts_with("\"\"\"") || text.starts_with("'''")) {
+		return false;
+	}
+	if (!text.empty() && text[0] == '\'') {
+		const std::size_t close = text.find('\'', 1);
+		if (close == std::string_view::npos) {
+			return false;
+		}
+		out.assign(text.substr(1, close - 1));
+		rest = text.substr(close + 1);
+		return true;
+	}
+	if (text.empty() || text[0] != '"') {
+		return false;
+	}
+
+	out.clear();
+	std::size_t i = 1;
+	while (true) {
+		const std::size_t special = text.find_first_of("\"\\", i);
+		if (special == std::string_view::npos) {
+			return false;
+		}
+		const std::string_view run = text.substr(i, special - i);
+		for (char c : run) {
+			const unsigned char u = static_cast<unsigned char>(c);
+			if ((u < 0x20 && c != '\t') || u == 0x7F) {
+				return false;
+			}
+		}
+		out.append(run);
+		if (text[special] == '"') {
+			rest = text.substr(special + 1);
+			return true;
+		}
+
+		if (special + 1 >= text.size()) {
+			return false;
+		}
+		i = special + 2;
+		switch (text[special + 1]) {
+		case 'b': out += '\b'; break;
+		case 't': out += '\t'; break;
+		case 'n': out += '\n'; break;
+		case 'f': out += '\f'; break;
+		case 'r': out += '\r'; break;
+		case '"': out += '"'; break;
+		case '\\': out += '\\'; break;
+		case 'u':
+		case 'U': {
+			const std::size_t digits = text[special + 1] == 'u' ? 4 : 8;
+			if (i + digits > text.size()) {
+				return false;
+			}
+			std::uint32_t cp = 0;
+			for (std::size_t d = 0; d < digits; ++d) {
+				const char h = text[i + d];
+				cp <<= 4;
+				if (h >= '0' && h <= '9') cp |= h - '0';
+				else if (h >= 'a' && h <= 'f') cp |= h - 'a' + 10;
+				else if (h >= 'A' && h <= 'F') cp |= h - 'A' + 10;
+				else return false;
+			}
+			if (!toml_append_utf8(out, cp)) {
+				return false;
+			}
+			i += digits;
+			break;
+		}
+		default:
+			return false;
+		}
+	}
+}
+
+static std::optional<toml_fast_result> parse_servers_toml_fast(std::string_view input) {
+	enum field : unsigned char { none = 0, icon = 1, ip = 2, name = 4, accept_textures = 8 };
+
+	toml_fast_result result{};
+	bool in_table = false;
+	unsigned char seen = 0;
+	nbtserver entry{};
+
+	const auto finish_entry = [&]() {
+		if (!in_table) {
+			return;
+		}
+		if (entry.icon.empty() || entry.ip.empty() || entry.name.empty()) {
+			++result.skipped;
+		} else {
+			result.servers.emplace_back(std::move(entry));
+		}
+		entry = nbtserver{};
+		seen = 0;
+	};
+
+	std::size_t pos = 0;
+	while (pos < input.size()) {
+		std::size_t end = input.find('\n', pos);
+		if (end == std::string_view::npos) {
+			end = input.size();
+		}
+		std::string_view line = input.substr(pos, end - pos);
+		pos = end + 1;
+		if (line.ends_with('\r')) {
+			line.remove_suffix(1);
+		}
+
+		line = toml_skip_ws(line);
+		if (line.empty() || line[0] == '#') {
 			continue;
 		}
 
-		servers.emplace_back(nbtserver{
-			.icon = server.at("icon").get<std::string>(),
-			.ip = server.at("ip").get<std::string>(),
-			.name = server.at("name").get<std::string>(),
-			.accept_textures = server.at("accept_textures").get<bool>()
-		});
+		if (line[0] == '[') {
+			std::string_view header = line.starts_with("[[") ? toml_skip_ws(line.substr(2)) : std::string_view{};
+			if (!header.starts_with("servers")) {
+				return std::nullopt;
+			}
+			header = toml_skip_ws(header.substr(7));
+			if (!header.starts_with("]]") || !toml_line_done(header.substr(2))) {
+				return std::nullopt;
+			}
+			finish_entry();
+			in_table = true;
+			continue;
+		}
+
+		if (!in_table) {
+			return std::nullopt;
+		}
+
+		std::size_t key_end = 0;
+		while (key_end < line.size() && (std::isalnum(static_cast<unsigned char>(line[key_end])) || line[key_end] == '_' || line[key_end] == '-')) {
+			++key_end;
+		}
+		const std::string_view key = line.substr(0, key_end);
+		std::string_view rest = toml_skip_ws(line.substr(key_end));
+		if (rest.empty() || rest[0] != '=') {
+			return std::nullopt;
+		}
+		rest = toml_skip_ws(rest.substr(1));
+
+		const field current = key == "icon" ? icon
+			: key == "ip" ? ip
+			: key == "name" ? name
+			: key == "accept_textures" ? accept_textures
+			: none;
+		if (current == none || (seen & current) != 0) {
+			return std::nullopt;
+		}
+		seen |= current;
+
+		if (current == accept_textures) {
+			if (rest.starts_with("true")) {
+				entry.accept_textures = true;
+				rest.remove_prefix(4);
+			} else if (rest.starts_with("false")) {
+				entry.accept_textures = false;
+				rest.remove_prefix(5);
+			} else {
+				return std::nullopt;
+			}
+		} else {
+			std::string& target = current == icon ? entry.icon : current == ip ? entry.ip : entry.name;
+			if (!toml_read_string(rest, target, rest)) {
+				return std::nullopt;
+			}
+		}
+
+		if (!toml_line_done(rest)) {
+			return std::nullopt;
+		}
 	}
 
-	return servers;
+	if (!in_table) {
+		return std::nullopt;
+	}
+	finish_entry();
+	return result;
 }
 
 std::vector<nbtserver> parse_servers_toml(const std::string& content) {
@@ -53,6 +414,13 @@ std::vector<nbtserver> parse_servers_toml(const std::string& content) {
 		return {};
 	}
 
+	if (auto fast = parse_servers_toml_fast(content)) {
+		for (std::size_t i = 0; i < fast->skipped; ++i) {
+			std::cout << "warning: a server entry is missing required fields. it will not be added to the servers list\n";
+		}
+		return std::move(fast->servers);
+	}
+
   	const auto maybe_parsed = toml::try_parse_str(content);
 	if (!maybe_parsed.is_ok()) {
 		// TODO show error source from try_parse?
@@ -92,108 +460,543 @@ std::vector<nbtserver> parse_servers_toml(const std::string& content) {
 	return servers;
 }
 
-std::vector<nbtserver> parse_servers_csv(const std::string& content) {
+// Call on_token(pos, is_newline) for every delimiter and newline in input,
+// in order. Bytes are classified 64 at a time so long icon fields without
+// structural characters cost one SIMD compare per block.
+template<typename F>
+static void for_each_csv_token(std::string_view input, F&& on_token) {
+	const char* data = input.data();
+	const std::size_t size = input.size();
+	for (std::size_t base = 0; base < size; base += 64) {
+		csv_block_masks masks;
+		if (size - base >= 64) {
+			masks = scan_csv_block(data + base);
+		} else {
+			// zero padding never matches a delimiter or newline
+			char tail[64] = {};
+			std::memcpy(tail, data + base, size - base);
+			masks = scan_csv_block(tail);
+		}
+
+		std::uint64_t bits = masks.delims | masks.newlines;
+		while (bits != 0) {
+			const int i = std::countr_zero(bits);
+			on_token(base + i, ((masks.newlines >> i) & 1) != 0);
+			bits &= bits - 1;
+		}
+	}
+}
+
+static std::size_t count_csv_newlines(std::string_view input) {
+	std::size_t count = 0;
+	for (std::size_t base = 0; base + 64 <= input.size(); base += 64) {
+		count += std::popcount(scan_csv_block(input.data() + base).newlines);
+	}
+	const std::size_t tail = input.size() - input.size() % 64;
+	return count + std::count(input.begin() + tail, input.end(), '\n');
+}
+
+// Parse the complete lines in input, appending to servers. Returns the
+// number of lines skipped for missing fields; the caller prints warnings.
+static std::size_t parse_csv_lines(std::string_view input, std::vector<nbtserver>& servers) {
+	servers.reserve(servers.size() + count_csv_newlines(input));
+
+	// get nbt properties for each server from the first three delimiters of its line
+	// Example: Server Name,base6409ujisdfskdf,127.0.0.1,0
+	std::size_t skipped = 0;
+	std::size_t line_start = 0;
+	std::size_t delims[3];
+	std::size_t delim_count = 0;
+
+	const auto finish_line = [&](std::size_t line_end) {
+		// a fourth field exists only if something follows the third delimiter
+		if (delim_count < 3 || delims[2] + 1 >= line_end) {
+			++skipped;
+		} else {
+			servers.emplace_back(nbtserver{
+				.icon = std::string(input.substr(delims[0] + 1, delims[1] - delims[0] - 1)),
+				.ip = std::string(input.substr(delims[1] + 1, delims[2] - delims[1] - 1)),
+				.name = std::string(input.substr(line_start, delims[0] - line_start)),
+				.accept_textures = input[delims[2] + 1] == '1'
+			});
+		}
+		line_start = line_end + 1;
+		delim_count = 0;
+	};
+
+	for_each_csv_token(input, [&](std::size_t pos, bool is_newline) {
+		if (is_newline) {
+			finish_line(pos);
+		} else if (delim_count < 3) {
+			delims[delim_count++] = pos;
+		}
+	});
+	if (line_start < input.size()) {
+		finish_line(input.size());
+	}
+
+	return skipped;
+}
+
+unsigned resolve_thread_count(unsigned requested) {
+	if (requested != 0) {
+		return requested;
+	}
+	if (const char* env = std::getenv("ENBT_THREADS")) {
+		const unsigned long from_env = std::strtoul(env, nullptr, 10);
+		if (from_env != 0) {
+			return static_cast<unsigned>(std::min<unsigned long>(from_env, 1024));
+		}
+	}
+	return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Below this much input per thread, splitting costs more than it saves
+static constexpr std::size_t csv_min_chunk_size = 1 << 20;
+
+std::vector<nbtserver> parse_servers_csv(const std::string& content, unsigned threads) {
 	if (content.empty()) {
 		std::cout << "csv file content is empty. no servers.dat created\n";
 		return {};
 	}
 	
-	const size_t server_count = std::count(content.begin(), content.end(), '\n');
+	const std::string_view input{content};
+	const std::size_t chunk_count = std::min<std::size_t>(
+		resolve_thread_count(threads),
+		std::max<std::size_t>(1, input.size() / csv_min_chunk_size));
+
+	// split at newline boundaries so every chunk holds whole lines
+	std::vector<std::string_view> chunks{};
+	chunks.reserve(chunk_count);
+	std::size_t chunk_start = 0;
+	for (std::size_t i = 1; i < chunk_count && chunk_start < input.size(); ++i) {
+		const std::size_t target = std::max(chunk_start, input.size() * i / chunk_count);
+		const std::size_t newline = input.find('\n', target);
+		if (newline == std::string_view::npos) {
+			break;
+		}
+		chunks.push_back(input.substr(chunk_start, newline + 1 - chunk_start));
+		chunk_start = newline + 1;
+	}
+	if (chunk_start < input.size()) {
+		chunks.push_back(input.substr(chunk_start));
+	}
 
-	std::vector<nbtserver> servers{};
-	servers.reserve(server_count);
-
-	std::string line;
-	std::istringstream stream{content};
-	while (std::getline(stream, line)) {
-		// get nbt properties for this server by splitting delimiter
-		// Example: Server Name,base6409ujisdfskdf,127.0.0.1,0
-		std::vector<std::string> items{};
-		for (std::size_t i = 0, pos = 0; pos < line.size(); ++i) {
-			auto const next_pos = std::find_if(line.begin() + pos, line.end(), [](auto& c){return c == ','||c=='|'||c==';';}) - line.begin();
-			items.push_back(line.substr(pos, next_pos - pos));
-			pos = next_pos == line.size() ? line.size() : next_pos + 1;
-		}	
-
-		if (items.size() < 4) {
+	std::vector<std::vector<nbtserver>> results(chunks.size());
+	std::vector<std::size_t> skipped(chunks.size(), 0);
+	if (chunks.size() == 1) {
+		skipped[0] = parse_csv_lines(chunks[0], results[0]);
+	} else {
+		std::vector<std::thread> workers{};
+		workers.reserve(chunks.size());
+		for (std::size_t i = 0; i < chunks.size(); ++i) {
+			workers.emplace_back([&, i]() {
+				skipped[i] = parse_csv_lines(chunks[i], results[i]);
+			});
+		}
+		for (auto& worker : workers) {
+			worker.join();
+		}
+	}
+
+	for (std::size_t i = 0; i < chunks.size(); ++i) {
+		for (std::size_t j = 0; j < skipped[i]; ++j) {
 			std::cout << "warning: a server entry is missing required fields. it will not be added to the servers list\n";
-			continue;
 		}
+	}
 
-		servers.emplace_back(nbtserver{
-			.icon = items[1],
-			.ip = items[2],
-			.name = items[0],
-			.accept_textures = items[3][0] == '1'
-		});
+	if (results.size() == 1) {
+		return std::move(results[0]);
 	}
 
+	// concatenate in input order
+	std::size_t total = 0;
+	for (const auto& result : results) {
+		total += result.size();
+	}
+	std::vector<nbtserver> servers{};
+	servers.reserve(total);
+	for (auto& result : results) {
+		std::move(result.begin(), result.end(), std::back_inserter(servers));
+	}
 	return servers;
 }
 
-std::vector<nbtserver> parse_servers_dat(const std::string& filepath) {
-	if (filepath.empty()) {
-		std::cout << "servers.dat path is empty\n";
-		return {};
+// Tags of a servers list entry that map onto nbtserver members
+enum class server_field : unsigned char { unknown, name, icon, ip, accept_textures };
+
+struct server_field_key {
+	std::string_view name;
+	char type;
+	server_field field;
+};
+
+// Perfect hash over the known tag names: length plus first byte, 8 slots
+constexpr std::size_t server_field_slot(std::string_view name) {
+	return (name.size() + static_cast<unsigned char>(name[0])) & 7;
+}
+
+constexpr std::array<server_field_key, 8> server_field_table = [] {
+	constexpr server_field_key keys[] = {
+		{"name", NBT::idString, server_field::name},
+		{"icon", NBT::idString, server_field::icon},
+		{"ip", NBT::idString, server_field::ip},
+		{"acceptTextures", NBT::idByte, server_field::accept_textures},
+	};
+	std::array<server_field_key, 8> table{};
+	for (const auto& key : keys) {
+		table[server_field_slot(key.name)] = key;
+	}
+	return table;
+}();
+
+static_assert(server_field_table[server_field_slot("name")].field == server_field::name
+	&& server_field_table[server_field_slot("icon")].field == server_field::icon
+	&& server_field_table[server_field_slot("ip")].field == server_field::ip
+	&& server_field_table[server_field_slot("acceptTextures")].field == server_field::accept_textures,
+	"server field names collide in server_field_table");
+
+// A tag only counts as a known field when both its name and type match
+static server_field lookup_server_field(std::string_view name, char type) {
+	if (name.empty()) {
+		return server_field::unknown;
 	}
+	const server_field_key& key = server_field_table[server_field_slot(name)];
+	return key.type == type && key.name == name ? key.field : server_field::unknown;
+}
 
-	if (!std::filesystem::exists(filepath)) {
-		std::cout << "servers.dat file doesn't exist: " << filepath << "\n";
+// Decode the tags of one entry compound in any order, skipping tags that
+// are unknown or of an unexpected type (e.g. vanilla's "hidden")
+template <typename Reader>
+static NBT::Result<void> read_server_fields(Reader& reader, nbtserver& server) {
+	const auto read_string = [&](std::string& out) -> NBT::Result<void> {
+		auto text = reader.tryReadStringPayloadView();
+		if (!text) {
+			return std::unexpected(text.error());
+		}
+		out = *text;
 		return {};
+	};
+
+	while (true) {
+		auto type = reader.tryPeekTagType();
+		if (!type) {
+			return std::unexpected(type.error());
+		}
+		// TAG_End is left for exitCompound
+		if (*type == NBT::idEnd) {
+			return {};
+		}
+		if (auto consumed = reader.tryReadTagType(); !consumed) {
+			return std::unexpected(consumed.error());
+		}
+		auto name = reader.tryReadTagNameView();
+		if (!name) {
+			return std::unexpected(name.error());
+		}
+
+		NBT::Result<void> field;
+		switch (lookup_server_field(*name, *type)) {
+		case server_field::name:
+			field = read_string(server.name);
+			break;
+		case server_field::icon:
+			field = read_string(server.icon);
+			break;
+		case server_field::ip:
+			field = read_string(server.ip);
+			break;
+		case server_field::accept_textures:
+			if (auto flag = reader.tryReadBytePayload()) {
+				server.accept_textures = *flag != 0;
+			} else {
+				field = std::unexpected(flag.error());
+			}
+			break;
+		case server_field::unknown:
+			field = reader.trySkipTag(*type);
+			break;
+		}
+		if (!field) {
+			return field;
+		}
 	}
+}
 
-	try {
-		NBT::NBTReader reader(filepath.c_str());
+// Decode the servers list, handing each valid entry to on_server as soon as
+// it has been read. Returns the number of entries delivered.
+template <typename Reader>
+static NBT::Result<std::size_t> read_servers(Reader& reader, const std::function<void(nbtserver&&)>& on_server) {
+	// Read "servers" list
+	char elementType;
+	int serverCount;
+	if (auto head = reader.tryReadListHead("servers", &elementType, &serverCount); !head) {
+		return std::unexpected(head.error());
+	}
 
-		// Read "servers" list
-		char elementType;
-		int serverCount;
-		reader.readListHead("servers", &elementType, &serverCount);
+	if (elementType != NBT::idCompound) {
+		std::cerr << "Invalid servers.dat: 'servers' list should contain compounds\n";
+		return 0;
+	}
 
-		if (elementType != NBT::idCompound) {
-			std::cout << "Invalid servers.dat: 'servers' list should contain compounds\n";
-			return {};
+	std::size_t delivered = 0;
+	for (int i = 0; i < serverCount; i++) {
+		nbtserver server;
+		server.accept_textures = false;
+		NBT::Result<void> entry = reader.tryEnterCompound();
+		if (entry) {
+			entry = read_server_fields(reader, server);
+		}
+		if (entry) {
+			entry = reader.tryExitCompound();
+		}
+		if (!entry) {
+			return std::unexpected(entry.error());
 		}
 
-		std::vector<nbtserver> servers;
-		servers.reserve(serverCount);
+		// Validate required fields; icon is optional in vanilla files
+		if (server.name.empty() || server.ip.empty()) {
+			std::cerr << "Warning: server entry missing required fields, skipping\n";
+			continue;
+		}
 
-		for (int i = 0; i < serverCount; i++) {
-			reader.enterCompound();
+		on_server(std::move(server));
+		++delivered;
+	}
 
-			nbtserver server;
-			server.accept_textures = false;
-			bool valid = true;
+	reader.close();
+	return delivered;
+}
 
-			// Read the 4 expected tags in order
-			try {
-				server.name = reader.readString("name");
-				server.icon = reader.readString("icon");
-				server.ip = reader.readString("ip");
-				server.accept_textures = reader.readByte("acceptTextures") != 0;
-			} catch (const std::exception& e) {
-				std::cout << "Warning: error reading server: " << e.what() << "\n";
-				valid = false;
-			}
+// Open and decode with the non-throwing reader API, reporting the first error.
+// Reader picks the byte order; source is a path or an in-memory span.
+template <typename Reader, typename Source>
+static bool read_servers_from(const Source& source, const std::function<void(nbtserver&&)>& on_server) {
+	Reader reader;
+	const NBT::Result<void> opened = reader.tryOpen(source);
+	NBT::Error error;
+	if (!opened) {
+		error = opened.error();
+	} else if (auto read = read_servers(reader, on_server); !read) {
+		error = read.error();
+	} else {
+		return true;
+	}
+	std::cerr << "Error reading servers.dat: " << error.message() << "\n";
+	return false;
+}
 
-			reader.exitCompound();
+template <typename Source>
+static bool read_servers_from(const Source& source, const std::function<void(nbtserver&&)>& on_server, nbt_flavor flavor) {
+	if (flavor == nbt_flavor::bedrock) {
+		return read_servers_from<NBT::NBTReaderLE>(source, on_server);
+	}
+	return read_servers_from<NBT::NBTReader>(source, on_server);
+}
 
-			// Validate required fields
-			if (server.name.empty() || server.ip.empty()) {
-				std::cout << "Warning: server entry missing required fields, skipping\n";
-				continue;
-			}
+static bool servers_dat_exists(const std::string& filepath) {
+	if (filepath.empty()) {
+		std::cerr << "servers.dat path is empty\n";
+		return false;
+	}
 
-			if (valid) {
-				servers.push_back(server);
-			}
+	if (!std::filesystem::exists(filepath)) {
+		std::cerr << "servers.dat file doesn't exist: " << filepath << "\n";
+		return false;
+	}
+	return true;
+}
+
+bool read_servers_dat(const std::string& filepath, const std::function<void(nbtserver&&)>& on_server, nbt_flavor flavor) {
+	if (!servers_dat_exists(filepath)) {
+		return false;
+	}
+
+	return read_servers_from(filepath.c_str(), on_server, flavor);
+}
+
+// Below this much NBT per thread, the structural pre-pass costs more than
+// decoding in parallel saves
+static constexpr std::size_t dat_min_chunk_size = 1 << 20;
+
+// Decode the entries of one chunk with a reader of its own, seeking to each
+template <typename Reader>
+static NBT::Result<void> decode_entries(std::span<const std::byte> data, std::span<const server_offsets> entries, nbtserver* out) {
+	Reader reader;
+	if (auto opened = reader.tryOpen(data); !opened) {
+		return opened;
+	}
+	for (std::size_t i = 0; i < entries.size(); ++i) {
+		out[i].accept_textures = false;
+		NBT::Result<void> entry = reader.trySeekCompound(entries[i].offset);
+		if (entry) {
+			entry = read_server_fields(reader, out[i]);
+		}
+		if (entry) {
+			entry = reader.tryExitCompound();
+		}
+		if (!entry) {
+			return entry;
+		}
+	}
+	return {};
+}
+
+// Two phases: a single-threaded structural scan records where every entry
+// starts (see server_index), then workers decode runs of entries of about
+// equal byte size straight into their slots. Returns nullopt when the data
+// is too small to split or is malformed, so the caller falls back to
+// read_servers_from, which streams and reports errors as usual.
+static std::optional<std::vector<nbtserver>> parse_servers_parallel(std::span<const std::byte> data, nbt_flavor flavor, unsigned threads) {
+	const std::size_t chunk_count = std::min<std::size_t>(
+		resolve_thread_count(threads),
+		data.size() / dat_min_chunk_size);
+	if (chunk_count < 2 || NBT::isGzip(reinterpret_cast<const char*>(data.data()), data.size())) {
+		return std::nullopt;
+	}
+
+	const auto scanned = scan_server_index(data, flavor);
+	if (!scanned || scanned->empty()) {
+		return std::nullopt;
+	}
+	const std::vector<server_offsets>& entries = *scanned;
+
+	// Chunk boundaries by bytes, since icons make entry sizes uneven
+	const std::uint64_t first = entries.front().offset;
+	const std::uint64_t total = entries.back().offset + entries.back().length - first;
+	std::vector<std::size_t> bounds{0};
+	for (std::size_t i = 1; i < chunk_count; ++i) {
+		const std::uint64_t target = first + total * i / chunk_count;
+		const auto split = std::lower_bound(entries.begin() + bounds.back(), entries.end(), target,
+			[](const server_offsets& entry, std::uint64_t offset) { return entry.offset < offset; });
+		bounds.push_back(static_cast<std::size_t>(split - entries.begin()));
+	}
+	bounds.push_back(entries.size());
+
+	std::vector<nbtserver> decoded(entries.size());
+	std::vector<NBT::Result<void>> results(chunk_count);
+	std::vector<std::thread> workers{};
+	workers.reserve(chunk_count);
+	for (std::size_t i = 0; i < chunk_count; ++i) {
+		workers.emplace_back([&, i]() {
+			const std::span<const server_offsets> chunk(entries.begin() + bounds[i], entries.begin() + bounds[i + 1]);
+			results[i] = flavor == nbt_flavor::bedrock
+				? decode_entries<NBT::NBTReaderLE>(data, chunk, decoded.data() + bounds[i])
+				: decode_entries<NBT::NBTReader>(data, chunk, decoded.data() + bounds[i]);
+		});
+	}
+	for (auto& worker : workers) {
+		worker.join();
+	}
+	for (const auto& result : results) {
+		if (!result) {
+			return std::nullopt;
 		}
+	}
 
-		reader.close();
-		return servers;
+	// Drop incomplete entries in list order, as read_servers does
+	std::vector<nbtserver> servers{};
+	servers.reserve(decoded.size());
+	for (nbtserver& server : decoded) {
+		if (server.name.empty() || server.ip.empty()) {
+			std::cerr << "Warning: server entry missing required fields, skipping\n";
+			continue;
+		}
+		servers.push_back(std::move(server));
+	}
+	return servers;
+}
 
-	} catch (const std::exception& e) {
-		std::cout << "Error reading servers.dat: " << e.what() << "\n";
+// The file is mapped once; the sequential reader falls back to the same
+// mapping rather than opening the path again
+std::vector<nbtserver> parse_servers_dat(const std::string& filepath, nbt_flavor flavor, unsigned threads) {
+	if (!servers_dat_exists(filepath)) {
 		return {};
 	}
+
+	NBT::MappedFile mapping;
+	if (!mapping.open(filepath.c_str())) {
+		std::cerr << "Unable to open servers.dat: " << filepath << "\n";
+		return {};
+	}
+	const std::span<const std::byte> data(reinterpret_cast<const std::byte*>(mapping.data()), mapping.size());
+	if (auto servers = parse_servers_parallel(data, flavor, threads)) {
+		return std::move(*servers);
+	}
+
+	std::vector<nbtserver> servers;
+	if (!read_servers_from(data, [&](nbtserver&& server) { servers.push_back(std::move(server)); }, flavor)) {
+		return {};
+	}
+	return servers;
+}
+
+std::vector<nbtserver> parse_servers_dat(std::span<const std::byte> data, nbt_flavor flavor, unsigned threads) {
+	if (data.empty()) {
+		std::cerr << "servers.dat content is empty\n";
+		return {};
+	}
+
+	if (auto servers = parse_servers_parallel(data, flavor, threads)) {
+		return std::move(*servers);
+	}
+
+	std::vector<nbtserver> servers;
+	if (!read_servers_from(data, [&](nbtserver&& server) { servers.push_back(std::move(server)); }, flavor)) {
+		return {};
+	}
+	return servers;
+}
+
+template <typename Reader>
+static NBT::Result<nbtserver> read_server_from(std::span<const std::byte> data, std::uint64_t offset) {
+	Reader reader;
+	if (auto opened = reader.tryOpen(data); !opened) {
+		return std::unexpected(opened.error());
+	}
+	nbtserver server;
+	server.accept_textures = false;
+	NBT::Result<void> entry = reader.trySeekCompound(offset);
+	if (entry) {
+		entry = read_server_fields(reader, server);
+	}
+	if (entry) {
+		entry = reader.tryExitCompound();
+	}
+	if (!entry) {
+		return std::unexpected(entry.error());
+	}
+	return server;
+}
+
+std::optional<nbtserver> parse_server_at(std::span<const std::byte> data, std::uint64_t offset, nbt_flavor flavor) {
+	const NBT::Result<nbtserver> server = flavor == nbt_flavor::bedrock
+		? read_server_from<NBT::NBTReaderLE>(data, offset)
+		: read_server_from<NBT::NBTReader>(data, offset);
+	if (!server) {
+		std::cerr << "Error reading servers.dat entry: " << server.error().message() << "\n";
+		return std::nullopt;
+	}
+	return *server;
+}
+
+template <typename Reader>
+static NBT::Result<void> check_structure(const char* filepath) {
+	Reader reader;
+	if (auto opened = reader.tryOpen(filepath); !opened) {
+		return opened;
+	}
+	return reader.tryValidate();
+}
+
+bool check_servers_dat(const std::string& filepath, nbt_flavor flavor) {
+	const NBT::Result<void> checked = flavor == nbt_flavor::bedrock
+		? check_structure<NBT::NBTReaderLE>(filepath.c_str())
+		: check_structure<NBT::NBTReader>(filepath.c_str());
+	if (!checked) {
+		std::cout << filepath << ": " << checked.error().message() << "\n";
+		return false;
+	}
+	std::cout << filepath << ": OK\n";
+	return true;
 }
@@ -1,46 +1,206 @@
 #include "serialize.hpp"
-#include "nlohmann/json.hpp"
 #include <sstream>
+#include <stdexcept>
+#include <streambuf>
 
-std::string serialize_servers_csv(const std::vector<nbtserver>& servers) {
-    std::ostringstream oss;
-    for (const auto& server : servers) {
-        oss << server.name << ','
-            << server.icon << ','
-            << server.ip << ','
-            << (server.accept_textures ? '1' : '0') << '\n';
+static void write_server_csv(std::ostream& out, const nbtserver& server) {
+    out << server.name << ','
+        << server.icon << ','
+        << server.ip << ','
+        << (server.accept_textures ? '1' : '0') << '\n';
+}
+
+static void put(std::streambuf& buf, std::string_view text) {
+    buf.sputn(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
+// Length of the well-formed UTF-8 sequence starting at value[i] (RFC 3629:
+// no overlong forms, surrogates or code points past U+10FFFF), or 0
+static std::size_t utf8_sequence_length(std::string_view value, std::size_t i) {
+    const auto byte = [&](std::size_t k) { return static_cast<unsigned char>(value[k]); };
+    const unsigned char lead = byte(i);
+    std::size_t length = 0;
+    unsigned char low = 0x80;
+    unsigned char high = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        low = lead == 0xE0 ? 0xA0 : 0x80;
+        high = lead == 0xED ? 0x9F : 0xBF;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        low = lead == 0xF0 ? 0x90 : 0x80;
+        high = lead == 0xF4 ? 0x8F : 0xBF;
+    } else {
+        return 0;
     }
-    return oss.str();
+    if (i + length > value.size() || byte(i + 1) < low || byte(i + 1) > high) {
+        return 0;
+    }
+    for (std::size_t k = 2; k < length; ++k) {
+        if ((byte(i + k) & 0xC0) != 0x80) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+// Quote and escape value the way nlohmann's dump() does with
+// ensure_ascii off: only '"', '\\' and control characters are escaped.
+// Unescaped runs are copied in one go. Like dump(), invalid UTF-8 throws
+// rather than producing a document JSON parsers would reject.
+static void put_json_string(std::streambuf& buf, std::string_view value) {
+    static constexpr char hex[] = "0123456789abcdef";
+    buf.sputc('"');
+    std::size_t run_start = 0;
+    for (std::size_t i = 0; i < value.size(); ++i) {
+        const unsigned char c = static_cast<unsigned char>(value[i]);
+        if (c >= 0x80) {
+            const std::size_t length = utf8_sequence_length(value, i);
+            if (length == 0) {
+                const char byte_hex[] = {hex[c >> 4], hex[c & 0xF], '\0'};
+                throw std::invalid_argument("invalid UTF-8 byte at index " + std::to_string(i) + ": 0x" + byte_hex);
+            }
+            i += length - 1;
+            continue;
+        }
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        put(buf, value.substr(run_start, i - run_start));
+        run_start = i + 1;
+        switch (c) {
+        case '"': put(buf, "\\\""); break;
+        case '\\': put(buf, "\\\\"); break;
+        case '\b': put(buf, "\\b"); break;
+        case '\f': put(buf, "\\f"); break;
+        case '\n': put(buf, "\\n"); break;
+        case '\r': put(buf, "\\r"); break;
+        case '\t': put(buf, "\\t"); break;
+        default: {
+            const char escaped[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+            buf.sputn(escaped, sizeof(escaped));
+            break;
+        }
+        }
+    }
+    put(buf, value.substr(run_start));
+    buf.sputc('"');
 }
 
-std::string serialize_servers_json(const std::vector<nbtserver>& servers) {
-    using json = nlohmann::json;
-    json output;
-    output["servers"] = json::array();
+// Pretty layout matches nlohmann's dump(2) of {"servers": [...]} (keys
+// sorted, two spaces per level); compact matches dump()
+static void write_server_json(std::streambuf& buf, const nbtserver& server, bool first, json_layout layout) {
+    const bool pretty = layout == json_layout::pretty;
+    if (pretty) {
+        put(buf, first ? "\n    {\n      \"accept_textures\": " : ",\n    {\n      \"accept_textures\": ");
+        put(buf, server.accept_textures ? "true,\n      \"icon\": " : "false,\n      \"icon\": ");
+        put_json_string(buf, server.icon);
+        put(buf, ",\n      \"ip\": ");
+        put_json_string(buf, server.ip);
+        put(buf, ",\n      \"name\": ");
+        put_json_string(buf, server.name);
+        put(buf, "\n    }");
+    } else {
+        put(buf, first ? "{\"accept_textures\":" : ",{\"accept_textures\":");
+        put(buf, server.accept_textures ? "true,\"icon\":" : "false,\"icon\":");
+        put_json_string(buf, server.icon);
+        put(buf, ",\"ip\":");
+        put_json_string(buf, server.ip);
+        put(buf, ",\"name\":");
+        put_json_string(buf, server.name);
+        buf.sputc('}');
+    }
+}
 
-    for (const auto& server : servers) {
-        json entry;
-        entry["icon"] = server.icon;
-        entry["ip"] = server.ip;
-        entry["name"] = server.name;
-        entry["accept_textures"] = server.accept_textures;
-        output["servers"].push_back(entry);
+static void write_server_toml(std::ostream& out, const nbtserver& server) {
+    out << "[[servers]]\n";
+    out << "icon = \"" << server.icon << "\"\n";
+    out << "ip = \"" << server.ip << "\"\n";
+    out << "name = \"" << server.name << "\"\n";
+    out << "accept_textures = " << (server.accept_textures ? "true" : "false") << "\n";
+    out << "\n";
+}
+
+server_serializer::server_serializer(std::ostream& out, std::string_view format, json_layout layout)
+    : out(out),
+      format(format == "csv" ? output_format::csv
+             : format == "json" ? output_format::json
+             : format == "toml" ? output_format::toml
+             : output_format::unknown),
+      layout(layout) {
+    if (this->format == output_format::json) {
+        this->out << (layout == json_layout::pretty ? "{\n  \"servers\": [" : "{\"servers\":[");
     }
+}
 
-    return output.dump(2);  // Pretty print with 2-space indent
+void server_serializer::write(const nbtserver& server) {
+    switch (format) {
+    case output_format::csv:
+        write_server_csv(out, server);
+        break;
+    case output_format::json:
+        write_server_json(*out.rdbuf(), server, count == 0, layout);
+        break;
+    case output_format::toml:
+        write_server_toml(out, server);
+        break;
+    case output_format::unknown:
+        break;
+    }
+    ++count;
 }
 
-std::string serialize_servers_toml(const std::vector<nbtserver>& servers) {
-    std::ostringstream oss;
+void server_serializer::finish() {
+    if (format == output_format::json) {
+        if (layout == json_layout::compact) {
+            out << "]}";
+        } else {
+            out << (count == 0 ? "]\n}" : "\n  ]\n}");
+        }
+    }
+    out.flush();
+}
+
+void serialize_servers_csv(const std::vector<nbtserver>& servers, std::ostream& out) {
+    server_serializer serializer(out, "csv");
+    for (const auto& server : servers) {
+        serializer.write(server);
+    }
+    serializer.finish();
+}
 
+void serialize_servers_json(const std::vector<nbtserver>& servers, std::ostream& out, json_layout layout) {
+    server_serializer serializer(out, "json", layout);
     for (const auto& server : servers) {
-        oss << "[[servers]]\n";
-        oss << "icon = \"" << server.icon << "\"\n";
-        oss << "ip = \"" << server.ip << "\"\n";
-        oss << "name = \"" << server.name << "\"\n";
-        oss << "accept_textures = " << (server.accept_textures ? "true" : "false") << "\n";
-        oss << "\n";
+        serializer.write(server);
     }
+    serializer.finish();
+}
+
+void serialize_servers_toml(const std::vector<nbtserver>& servers, std::ostream& out) {
+    server_serializer serializer(out, "toml");
+    for (const auto& server : servers) {
+        serializer.write(server);
+    }
+    serializer.finish();
+}
 
+std::string serialize_servers_csv(const std::vector<nbtserver>& servers) {
+    std::ostringstream oss;
+    serialize_servers_csv(servers, oss);
+    return oss.str();
+}
+
+std::string serialize_servers_json(const std::vector<nbtserver>& servers, json_layout layout) {
+    std::ostringstream oss;
+    serialize_servers_json(servers, oss, layout);
+    return oss.str();
+}
+
+std::string serialize_servers_toml(const std::vector<nbtserver>& servers) {
+    std::ostringstream oss;
+    serialize_servers_toml(servers, oss);
     return oss.str();
 }
@@ -0,0 +1,285 @@
+#include "server_index.hpp"
+#include "NBTGzip.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+// Sidecar layout: magic, then the indexed file's size and modification time
+// and the flavor it was read as, the entry count and the raw entries. It is
+// a local cache in host byte order, rebuilt whenever any of these differ.
+static constexpr char index_magic[8] = {'E', 'N', 'B', 'T', 'I', 'D', 'X', '2'};
+
+// The smallest entry is an empty compound: its TAG_End alone
+static constexpr std::uint64_t min_entry_size = 1;
+
+struct index_stamp {
+	std::uint64_t file_size;
+	std::int64_t modified;
+	std::uint32_t flavor;
+	std::uint32_t reserved;
+	std::uint64_t count;
+};
+
+template <typename Reader>
+static NBT::Result<std::vector<server_offsets>> scan_servers(std::span<const std::byte> data) {
+	Reader reader;
+	if (auto opened = reader.tryOpen(data); !opened) {
+		return std::unexpected(opened.error());
+	}
+
+	char elementType;
+	int count;
+	if (auto head = reader.tryReadListHead("servers", &elementType, &count); !head) {
+		return std::unexpected(head.error());
+	}
+	std::vector<server_offsets> entries;
+	if (count == 0) {
+		return entries;
+	}
+	if (elementType != NBT::idCompound) {
+		return std::unexpected(NBT::Error{NBT::ErrorCode::ListTypeMismatch, reader.getByteCount(), NBT::idCompound, {}, {}});
+	}
+
+	// Every entry takes at least its TAG_End, so a corrupt count can't
+	// reserve more than the data could hold
+	entries.reserve(std::min<std::size_t>(count, data.size()));
+	for (int i = 0; i < count; i++) {
+		server_offsets entry{};
+		entry.offset = reader.getByteCount();
+		if (auto ok = reader.tryEnterCompound(); !ok) {
+			return std::unexpected(ok.error());
+		}
+		while (true) {
+			auto type = reader.tryPeekTagType();
+			if (!type) {
+				return std::unexpected(type.error());
+			}
+			if (*type == NBT::idEnd) {
+				break;
+			}
+			if (auto consumed = reader.tryReadTagType(); !consumed) {
+				return std::unexpected(consumed.error());
+			}
+			auto name = reader.tryReadTagNameView();
+			if (!name) {
+				return std::unexpected(name.error());
+			}
+			if (*type == NBT::idString) {
+				if (*name == "name") {
+					entry.name = reader.getByteCount();
+				} else if (*name == "ip") {
+					entry.ip = reader.getByteCount();
+				} else if (*name == "icon") {
+					entry.icon = reader.getByteCount();
+				}
+			} else if (*type == NBT::idByte && *name == "acceptTextures") {
+				entry.accept_textures = reader.getByteCount();
+			}
+			if (auto ok = reader.trySkipTag(*type); !ok) {
+				return std::unexpected(ok.error());
+			}
+		}
+		if (auto ok = reader.tryExitCompound(); !ok) {
+			return std::unexpected(ok.error());
+		}
+		entry.length = reader.getByteCount() - entry.offset;
+		entries.push_back(entry);
+	}
+	return entries;
+}
+
+NBT::Result<std::vector<server_offsets>> scan_server_index(std::span<const std::byte> data, nbt_flavor flavor) {
+	// Offsets into a deflate stream can't be seeked to; inflate first
+	if (NBT::isGzip(reinterpret_cast<const char*>(data.data()), data.size())) {
+		return std::unexpected(NBT::Error{NBT::ErrorCode::NotSeekable, 0, 0, {}, {}});
+	}
+	return flavor == nbt_flavor::bedrock
+		? scan_servers<NBT::NBTReaderLE>(data)
+		: scan_servers<NBT::NBTReader>(data);
+}
+
+std::optional<std::vector<server_offsets>> build_server_index(std::span<const std::byte> data, nbt_flavor flavor) {
+	auto entries = scan_server_index(data, flavor);
+	if (!entries) {
+		std::cerr << "Error indexing servers.dat: " << entries.error().message() << "\n";
+		return std::nullopt;
+	}
+	return std::move(*entries);
+}
+
+std::string server_index_path(const std::string& path) {
+	return path + ".idx";
+}
+
+static bool file_stamp(const std::string& path, nbt_flavor flavor, index_stamp& stamp) {
+	std::error_code error;
+	const auto size = fs::file_size(path, error);
+	if (error) {
+		return false;
+	}
+	const auto modified = fs::last_write_time(path, error);
+	if (error) {
+		return false;
+	}
+	stamp = {};
+	stamp.file_size = size;
+	stamp.modified = modified.time_since_epoch().count();
+	stamp.flavor = static_cast<std::uint32_t>(flavor);
+	return true;
+}
+
+// A field offset is 0 (absent) or inside its own entry
+static bool field_in_entry(std::uint64_t field, const server_offsets& entry) {
+	return field == 0 || (field >= entry.offset && field - entry.offset < entry.length);
+}
+
+// The sidecar is only trusted if it is exactly the size its count implies
+// and its entries tile the data in order without running past the end
+static bool load_index(const std::string& path, const index_stamp& expected, std::size_t data_size, std::vector<server_offsets>& entries) {
+	std::ifstream in(server_index_path(path), std::ios::binary | std::ios::ate);
+	const std::streamoff file_size = in.tellg();
+	in.seekg(0);
+	char magic[sizeof(index_magic)];
+	index_stamp stamp;
+	if (!in.read(magic, sizeof(magic)) || !in.read(reinterpret_cast<char*>(&stamp), sizeof(stamp))) {
+		return false;
+	}
+	if (std::memcmp(magic, index_magic, sizeof(magic)) != 0 || stamp.file_size != expected.file_size
+		|| stamp.modified != expected.modified || stamp.flavor != expected.flavor
+		|| stamp.count > data_size / min_entry_size
+		|| static_cast<std::uint64_t>(file_size) != sizeof(magic) + sizeof(stamp) + stamp.count * sizeof(server_offsets)) {
+		return false;
+	}
+	entries.resize(stamp.count);
+	if (!in.read(reinterpret_cast<char*>(entries.data()), entries.size() * sizeof(server_offsets))) {
+		return false;
+	}
+	std::uint64_t previous_end = 0;
+	for (const server_offsets& entry : entries) {
+		if (entry.offset < previous_end || entry.offset > data_size || entry.length < min_entry_size
+			|| entry.length > data_size - entry.offset) {
+			return false;
+		}
+		if (!field_in_entry(entry.name, entry) || !field_in_entry(entry.ip, entry)
+			|| !field_in_entry(entry.icon, entry) || !field_in_entry(entry.accept_textures, entry)) {
+			return false;
+		}
+		previous_end = entry.offset + entry.length;
+	}
+	return true;
+}
+
+static bool save_index(const std::string& path, index_stamp stamp, const std::vector<server_offsets>& entries) {
+	std::ofstream out(server_index_path(path), std::ios::binary | std::ios::trunc);
+	stamp.count = entries.size();
+	out.write(index_magic, sizeof(index_magic));
+	out.write(reinterpret_cast<const char*>(&stamp), sizeof(stamp));
+	out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(server_offsets));
+	return static_cast<bool>(out);
+}
+
+// Inflate a whole gzip file; the index needs offsets it can jump to
+static bool inflate_all(const char* data, std::size_t length, std::vector<std::byte>& out) {
+	NBT::Inflater inflater(data, length);
+	std::size_t used = 0;
+	out.resize(std::max<std::size_t>(length * 4, 1 << 16));
+	while (true) {
+		used += inflater.read(reinterpret_cast<char*>(out.data()) + used, out.size() - used);
+		if (used < out.size()) {
+			break;
+		}
+		out.resize(out.size() * 2);
+	}
+	out.resize(used);
+	return !inflater.failed();
+}
+
+bool server_index::open(const std::string& path, nbt_flavor flavor, bool persist) {
+	this->flavor = flavor;
+	entries.clear();
+	inflated.clear();
+	data = {};
+	if (!mapping.open(path.c_str())) {
+		std::cerr << "Unable to open servers.dat: " << path << "\n";
+		return false;
+	}
+
+	if (NBT::isGzip(mapping.data(), mapping.size())) {
+		if (!inflate_all(mapping.data(), mapping.size(), inflated)) {
+			std::cerr << "Error indexing servers.dat: corrupt gzip data\n";
+			return false;
+		}
+		// Nothing reads the compressed bytes again
+		mapping.close();
+		data = inflated;
+	} else {
+		data = std::span(reinterpret_cast<const std::byte*>(mapping.data()), mapping.size());
+	}
+
+	index_stamp stamp;
+	const bool stamped = file_stamp(path, flavor, stamp);
+	if (stamped && load_index(path, stamp, data.size(), entries)) {
+		return true;
+	}
+
+	entries.clear();
+	auto built = build_server_index(data, flavor);
+	if (!built) {
+		entries.clear();
+		return false;
+	}
+	entries = std::move(*built);
+	if (persist && stamped && !save_index(path, stamp, entries)) {
+		std::cerr << "Warning: could not write " << server_index_path(path) << "\n";
+	}
+	return true;
+}
+
+// A string payload: 16-bit length in the file's byte order, then the text
+std::string_view server_index::string_at(std::uint64_t offset) const {
+	if (offset == 0 || offset + 2 > data.size()) {
+		return {};
+	}
+	const auto* bytes = reinterpret_cast<const unsigned char*>(data.data()) + offset;
+	const std::size_t length = flavor == nbt_flavor::bedrock
+		? bytes[0] | bytes[1] << 8
+		: bytes[0] << 8 | bytes[1];
+	if (offset + 2 + length > data.size()) {
+		return {};
+	}
+	return std::string_view(reinterpret_cast<const char*>(bytes) + 2, length);
+}
+
+std::string_view server_index::name(std::size_t i) const {
+	return string_at(entries[i].name);
+}
+
+std::string_view server_index::ip(std::size_t i) const {
+	return string_at(entries[i].ip);
+}
+
+std::string_view server_index::icon(std::size_t i) const {
+	return string_at(entries[i].icon);
+}
+
+bool server_index::accept_textures(std::size_t i) const {
+	const std::uint64_t offset = entries[i].accept_textures;
+	return offset != 0 && offset < data.size() && data[offset] != std::byte{0};
+}
+
+std::optional<nbtserver> server_index::read(std::size_t i) const {
+	return parse_server_at(data, entries[i].offset, flavor);
+}
+
+nbtserver server_view::to_server() const {
+	nbtserver server;
+	server.name = name();
+	server.ip = ip();
+	server.icon = icon();
+	server.accept_textures = accept_textures();
+	return server;
+}
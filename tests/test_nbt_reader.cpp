@@ -1,6 +1,7 @@
 #include "acutest.h"
 #include "NBTReader.h"
 #include "NBTWriter.h"
+#include "NBTDocument.h"
 #include <filesystem>
 #include <cstdio>
 
@@ -59,6 +60,37 @@ void test_read_primitives(void) {
     std::remove(testfile.c_str());
 }
 
+// Test zero-copy string and name views
+void test_read_string_views(void) {
+    std::string testfile = get_temp_path("test_string_views.dat");
+
+    // Write test data
+    {
+        NBT::NBTWriter writer(testfile.c_str());
+        writer.writeString("first", "view one");
+        writer.writeString("second", "view two");
+        writer.endCompound();
+        writer.close();
+    }
+
+    // Read it back
+    {
+        NBT::NBTReader reader(testfile.c_str());
+
+        std::string_view first = reader.readStringView("first");
+        TEST_CHECK(first == "view one");
+
+        TEST_CHECK(reader.readTagType() == NBT::idString);
+        TEST_CHECK(reader.readTagNameView() == "second");
+
+        // Earlier views stay valid while the reader is open
+        TEST_CHECK(first == "view one");
+        reader.close();
+    }
+
+    std::remove(testfile.c_str());
+}
+
 // Test reading compound tags
 void test_read_compound(void) {
     std::string testfile = get_temp_path("test_compound.dat");
@@ -468,8 +500,657 @@ void test_read_byte_array(void) {
     std::remove(testfile.c_str());
 }
 
+// Test bulk array reads and writes against the element-by-element path
+void test_bulk_arrays(void) {
+    std::vector<int> ints(1001);
+    std::vector<long long> longs(333);
+    std::vector<char> bytes(77);
+    for (size_t i = 0; i < ints.size(); i++) ints[i] = static_cast<int>(i * 2654435761u);
+    for (size_t i = 0; i < longs.size(); i++) longs[i] = -static_cast<long long>(i) * 0x0010203040506070LL;
+    for (size_t i = 0; i < bytes.size(); i++) bytes[i] = static_cast<char>(i * 7);
+
+    std::vector<std::byte> data;
+    {
+        NBT::NBTWriter writer(data);
+        writer.writeIntArray("ints", ints);
+        writer.writeLongArrayHead("longs", static_cast<int>(longs.size()));
+        for (long long value : longs) writer.writeLong("", value);
+        writer.writeByteArray("bytes", bytes);
+        writer.writeInt("after", 42);
+        writer.close();
+    }
+
+    NBT::NBTReader reader(data);
+
+    // Bulk read in two parts
+    TEST_CHECK(reader.readIntArrayHead("ints") == 1001);
+    std::vector<int> readInts(ints.size());
+    reader.readIntArray(std::span<int>(readInts).first(500));
+    reader.readIntArray(std::span<int>(readInts).subspan(500));
+    TEST_CHECK(readInts == ints);
+
+    // Elements written one at a time read back in bulk
+    TEST_CHECK(reader.readLongArrayHead("longs") == 333);
+    std::vector<long long> readLongs(longs.size() + 1);
+    auto overrun = reader.tryReadLongArray(readLongs);
+    TEST_CHECK(!overrun && overrun.error().code == NBT::ErrorCode::ArrayOverrun);
+    readLongs.pop_back();
+    reader.readLongArray(readLongs);
+    TEST_CHECK(readLongs == longs);
+
+    // Bulk written bytes read one at a time
+    TEST_CHECK(reader.readByteArrayHead("bytes") == 77);
+    for (size_t i = 0; i < bytes.size(); i++) {
+        TEST_CHECK(reader.readByte() == bytes[i]);
+    }
+
+    TEST_CHECK(reader.readInt("after") == 42);
+}
+
+// Test that the byte order parameter only changes how values are stored
+void test_little_endian(void) {
+    std::vector<std::byte> big, little;
+    {
+        NBT::NBTWriter writer(big);
+        writer.writeInt("v", 0x01020304);
+        writer.close();
+    }
+    {
+        NBT::NBTWriterLE writer(little);
+        writer.writeInt("v", 0x01020304);
+        writer.close();
+    }
+
+    // Header (3) + type (1) + name length (2) + "v" (1)
+    TEST_CHECK(big.size() == little.size());
+    TEST_CHECK(big[5] == std::byte{1} && little[4] == std::byte{1});
+    TEST_CHECK(big[7] == std::byte{1} && big[10] == std::byte{4});
+    TEST_CHECK(little[7] == std::byte{4} && little[10] == std::byte{1});
+
+    NBT::NBTReaderLE reader(little);
+    TEST_CHECK(reader.readInt("v") == 0x01020304);
+}
+
+// Test gzip output and streamed decompression across window refills
+void test_gzip_roundtrip(void) {
+    std::vector<int> ints(100000);
+    for (size_t i = 0; i < ints.size(); i++) ints[i] = static_cast<int>(i % 1000);
+    std::string text(30000, 'x');
+    for (size_t i = 0; i < text.size(); i += 7) text[i] = static_cast<char>('a' + i % 26);
+
+    for (int level : {0, 1, 6, 9}) {
+        std::vector<std::byte> data;
+        {
+            NBT::NBTWriter writer(data);
+            writer.setCompression(level);
+            writer.writeIntArray("ints", ints);
+            for (int i = 0; i < 50; i++) writer.writeString("text", text.c_str());
+            writer.writeLong("after", -5);
+            writer.close();
+        }
+        TEST_CHECK(NBT::isGzip(reinterpret_cast<const char*>(data.data()), data.size()));
+
+        NBT::NBTReader reader(data);
+        std::vector<int> readInts(ints.size());
+        TEST_CHECK(reader.readIntArrayHead("ints") == 100000);
+        reader.readIntArray(readInts);
+        TEST_CHECK_(readInts == ints, "ints at level %d", level);
+        for (int i = 0; i < 50; i++) {
+            TEST_CHECK(reader.readStringView("text") == text);
+        }
+        TEST_CHECK(reader.readLong("after") == -5);
+        TEST_CHECK(reader.getByteCount() + 1 > 400000);
+    }
+
+    // A damaged checksum is reported instead of passing silently
+    std::vector<std::byte> data;
+    {
+        NBT::NBTWriter writer(data);
+        writer.setCompression(6);
+        for (int i = 0; i < 50; i++) writer.writeString("text", text.c_str());
+        writer.close();
+    }
+    data[data.size() - 6] ^= std::byte{0x40};
+    NBT::NBTReader reader(data);
+    NBT::Result<void> result;
+    for (int i = 0; i < 50 && result; i++) {
+        if (auto value = reader.tryReadStringView("text"); !value) {
+            result = std::unexpected(value.error());
+        }
+    }
+    if (result) {
+        result = reader.tryExitCompound();
+    }
+    TEST_CHECK(!result && result.error().code == NBT::ErrorCode::CorruptCompression);
+}
+
+// Records visitor callbacks as text; skips lists named "skipped"
+struct TraceVisitor : NBT::Visitor {
+    std::string trace;
+    bool onCompoundBegin(std::string_view name) override {
+        trace += "{" + std::string(name) + ";";
+        return true;
+    }
+    void onCompoundEnd() override { trace += "};"; }
+    bool onListBegin(std::string_view name, char elementType, int count) override {
+        trace += "[" + std::string(name) + " " + std::to_string(elementType) + " " + std::to_string(count) + ";";
+        if (name == "skipped") {
+            trace += "];";
+            return false;
+        }
+        return true;
+    }
+    void onListEnd() override { trace += "];"; }
+    void onTag(std::string_view name, const NBT::TagValue& value) override {
+        trace += std::string(name) + "=";
+        switch (value.type) {
+            case NBT::idFloat:
+            case NBT::idDouble: trace += std::to_string(value.real); break;
+            case NBT::idString: trace += value.bytes; break;
+            case NBT::idIntArray: trace += "ints " + std::to_string(value.count); break;
+            default: trace += std::to_string(value.integer); break;
+        }
+        trace += ";";
+    }
+};
+
+void test_visitor(void) {
+    std::vector<int> ids = {1, 2, 3};
+    for (int level : {-1, 6}) {
+        std::vector<std::byte> data;
+        {
+            NBT::NBTWriter writer(data);
+            if (level >= 0) writer.setCompression(level);
+            writer.writeInt("a", 7);
+            writer.writeCompound("pos");
+            writer.writeDouble("x", 1.5);
+            writer.writeString("world", "overworld");
+            writer.endCompound();
+            writer.writeListHead("items", NBT::idCompound, 2);
+            writer.writeCompound("");
+            writer.writeShort("n", 3);
+            writer.endCompound();
+            writer.writeCompound("");
+            writer.writeShort("n", -4);
+            writer.endCompound();
+            writer.writeIntArray("ids", ids);
+            writer.writeListHead("skipped", NBT::idInt, 3);
+            writer.writeInt("", 10);
+            writer.writeInt("", 20);
+            writer.writeInt("", 30);
+            writer.writeLong("after", -9);
+            writer.close();
+        }
+
+        NBT::NBTReader reader(data);
+        TraceVisitor visitor;
+        auto result = reader.tryVisit(visitor);
+        TEST_CHECK(result.has_value());
+        TEST_CHECK_(visitor.trace ==
+            "a=7;{pos;x=1.500000;world=overworld;};"
+            "[items 10 2;{;n=3;};{;n=-4;};];"
+            "ids=ints 3;[skipped 3 3;];after=-9;",
+            "trace at level %d: %s", level, visitor.trace.c_str());
+        TEST_CHECK(reader.getByteCount() > 0);
+    }
+
+    // Visiting the rest of a nested compound returns to its parent
+    std::vector<std::byte> data;
+    {
+        NBT::NBTWriter writer(data);
+        writer.writeCompound("inner");
+        writer.writeByte("b", 1);
+        writer.writeByte("c", 2);
+        writer.endCompound();
+        writer.writeInt("next", 5);
+        writer.close();
+    }
+    NBT::NBTReader reader(data);
+    reader.enterCompound("inner");
+    TEST_CHECK(reader.readByte("b") == 1);
+    TraceVisitor visitor;
+    reader.visit(visitor);
+    TEST_CHECK(visitor.trace == "c=2;");
+    TEST_CHECK(reader.readInt("next") == 5);
+    reader.exitCompound();
+}
+
+void test_document(void) {
+    std::vector<long long> longs = {1, -2, 1LL << 40};
+    std::vector<std::byte> original;
+    {
+        NBT::NBTWriter writer(original);
+        writer.writeString("name", "level");
+        writer.writeFloat("f", 0.25f);
+        writer.writeCompound("data");
+        writer.writeLongArray("longs", longs);
+        writer.writeListHead("nested", NBT::idList, 2);
+        writer.writeListHead("", NBT::idByte, 2);
+        writer.writeByte("", 1);
+        writer.writeByte("", 2);
+        writer.writeListHead("", NBT::idEnd, 0);
+        writer.endCompound();
+        writer.writeListHead("players", NBT::idCompound, 1);
+        writer.writeCompound("");
+        writer.writeInt("id", 42);
+        writer.endCompound();
+        writer.close();
+    }
+
+    NBT::Document doc;
+    NBT::NBTReader reader(original);
+    TEST_CHECK(doc.load(reader).has_value());
+    NBT::Node& root = doc.root();
+    TEST_CHECK(root.count == 4);
+    TEST_CHECK(root.find("name")->string() == "level");
+    TEST_CHECK(root.find("f")->real == 0.25);
+    const NBT::Node* data = root.find("data");
+    TEST_ASSERT(data != nullptr);
+    auto readLongs = data->find("longs")->longArray();
+    TEST_CHECK(std::vector<long long>(readLongs.begin(), readLongs.end()) == longs);
+    const NBT::Node* nested = data->find("nested");
+    TEST_ASSERT(nested != nullptr && nested->count == 2);
+    TEST_CHECK(nested->children()[0].children()[1].integer == 2);
+    TEST_CHECK(nested->children()[1].elementType == NBT::idEnd);
+    TEST_CHECK(root.find("players")->children()[0].find("id")->integer == 42);
+    TEST_CHECK(root.find("missing") == nullptr);
+
+    // Saving an unedited document reproduces the file
+    std::vector<std::byte> saved;
+    {
+        NBT::NBTWriter writer(saved);
+        doc.save(writer);
+        writer.close();
+    }
+    TEST_CHECK(saved == original);
+
+    // Edits survive a save and reload, also in little-endian
+    TEST_CHECK(doc.setString(*root.find("name"), "renamed"));
+    NBT::Node value{};
+    value.type = NBT::idInt;
+    value.integer = 7;
+    TEST_CHECK(doc.append(root, "added", value) != nullptr);
+    NBT::Node player{};
+    player.type = NBT::idCompound;
+    TEST_CHECK(doc.append(*root.find("players"), "", player) != nullptr);
+    // Lists keep a single element type
+    TEST_CHECK(doc.append(*root.find("players"), "", value) == nullptr);
+    TEST_CHECK(root.find("players")->count == 2);
+    // The first element of an empty list sets its type
+    NBT::Node& empty = root.find("data")->find("nested")->children()[1];
+    TEST_CHECK(doc.append(empty, "", value) != nullptr);
+    TEST_CHECK(empty.elementType == NBT::idInt);
+    std::vector<std::byte> edited;
+    {
+        NBT::NBTWriterLE writer(edited);
+        TEST_CHECK(doc.save(writer));
+        writer.close();
+    }
+    NBT::NBTReaderLE editedReader(edited);
+    NBT::Document reloaded;
+    TEST_CHECK(reloaded.load(editedReader).has_value());
+    TEST_CHECK(reloaded.root().find("name")->string() == "renamed");
+    TEST_CHECK(reloaded.root().find("added")->integer == 7);
+    TEST_CHECK(reloaded.root().find("players")->count == 2);
+    TEST_CHECK(reloaded.root().find("data")->find("nested")->children()[1].children()[0].integer == 7);
+    auto reloadedLongs = reloaded.root().find("data")->find("longs")->longArray();
+    TEST_CHECK(std::vector<long long>(reloadedLongs.begin(), reloadedLongs.end()) == longs);
+
+    // Strings are saved by length: embedded NULs and more than 32767 bytes
+    // survive, and more than 65535 bytes can't be stored
+    const std::string withNul("a\0b", 3);
+    const std::string longText(40000, 'x');
+    TEST_CHECK(doc.setString(*root.find("name"), withNul));
+    value.type = NBT::idString;
+    NBT::Node* text = doc.append(root, "long", value);
+    TEST_ASSERT(text != nullptr);
+    TEST_CHECK(doc.setString(*text, longText));
+    TEST_CHECK(!doc.setString(*text, std::string(70000, 'x')));
+    std::vector<std::byte> strings;
+    {
+        NBT::NBTWriter writer(strings);
+        TEST_CHECK(doc.save(writer));
+        writer.close();
+    }
+    NBT::NBTReader stringsReader(strings);
+    TEST_CHECK(reloaded.load(stringsReader).has_value());
+    TEST_CHECK(reloaded.root().find("name")->string() == withNul);
+    TEST_CHECK(reloaded.root().find("long")->string() == longText);
+
+    // A truncated file leaves an empty document and reports where it broke
+    std::vector<std::byte> cut(original.begin(), original.begin() + original.size() / 2);
+    NBT::NBTReader cutReader(cut);
+    auto result = doc.load(cutReader);
+    TEST_CHECK(!result && result.error().code == NBT::ErrorCode::UnexpectedEof);
+    TEST_CHECK(doc.root().count == 0);
+}
+
+// A moved-from arena owns nothing and starts a block of its own
+void test_arena_move(void) {
+    NBT::Arena first(64);
+    std::string_view kept = first.copyString("kept");
+    NBT::Arena second(std::move(first));
+    std::string_view fresh = first.copyString("fresh");
+    // Before, both arenas wrote into the same block and clobbered each other
+    TEST_CHECK(second.copyString("more") == "more");
+    TEST_CHECK(fresh == "fresh");
+    TEST_CHECK(kept == "kept");
+
+    NBT::Arena third;
+    third = std::move(second);
+    TEST_CHECK(second.copyString("again") == "again");
+    TEST_CHECK(kept == "kept");
+}
+
+void test_validate(void) {
+    std::vector<std::byte> data;
+    {
+        NBT::NBTWriter writer(data);
+        writer.writeListHead("servers", NBT::idCompound, 2);
+        for (int i = 0; i < 2; i++) {
+            writer.writeCompound("");
+            writer.writeString("name", "Server");
+            writer.writeString("ip", "localhost");
+            writer.writeByte("acceptTextures", 1);
+            writer.endCompound();
+        }
+        writer.writeListHead("ints", NBT::idInt, 3);
+        writer.writeInt("", 1);
+        writer.writeInt("", 2);
+        writer.writeInt("", 3);
+        writer.close();
+    }
+    {
+        NBT::NBTReader reader(data);
+        TEST_CHECK(reader.tryValidate().has_value());
+    }
+
+    // Cut short: the error points at the end of the data
+    std::vector<std::byte> cut(data.begin(), data.end() - 5);
+    {
+        NBT::NBTReader reader(cut);
+        auto result = reader.tryValidate();
+        TEST_CHECK(!result && result.error().code == NBT::ErrorCode::UnexpectedEof);
+    }
+
+    // A bad type byte is reported at its offset
+    std::vector<std::byte> bad = data;
+    bad[3] = std::byte{42};
+    {
+        NBT::NBTReader reader(bad);
+        auto result = reader.tryValidate();
+        TEST_CHECK(!result && result.error().code == NBT::ErrorCode::UnknownTagType);
+        TEST_CHECK(!result && result.error().offset == 3);
+    }
+
+    // Nesting deeper than VisitDepthLimit is rejected
+    std::vector<std::byte> deep = {std::byte{10}, std::byte{0}, std::byte{0}};
+    for (int i = 0; i < VisitDepthLimit; i++) {
+        deep.insert(deep.end(), {std::byte{10}, std::byte{0}, std::byte{0}});
+    }
+    deep.insert(deep.end(), VisitDepthLimit + 1, std::byte{0});
+    {
+        NBT::NBTReader reader(deep);
+        auto result = reader.tryValidate();
+        TEST_CHECK(!result && result.error().code == NBT::ErrorCode::TooDeep);
+    }
+    deep.erase(deep.begin() + 3, deep.begin() + 9);
+    deep.resize(deep.size() - 2);
+    {
+        NBT::NBTReader reader(deep);
+        TEST_CHECK(reader.tryValidate().has_value());
+    }
+}
+
+// Deeper than the stacks' inline levels, and than their old fixed size
+void test_deep_nesting(void) {
+    const int depth = 301;
+    std::vector<std::byte> data;
+    {
+        NBT::NBTWriter writer(data);
+        for (int i = 0; i < depth; i++) {
+            if (i % 2 == 0) {
+                writer.writeCompound("c");
+            } else {
+                writer.writeListHead("l", NBT::idCompound, 1);
+            }
+        }
+        writer.writeInt("leaf", depth);
+        for (int i = depth - 1; i >= 0; i--) {
+            if (i % 2 == 0) {
+                writer.endCompound();
+            }
+        }
+        writer.writeInt("after", 7);
+        writer.close();
+    }
+
+    NBT::NBTReader reader(data);
+    for (int i = 0; i < depth; i++) {
+        if (i % 2 == 0) {
+            TEST_ASSERT(reader.tryEnterCompound("c").has_value());
+        } else {
+            char elementType;
+            int count;
+            TEST_ASSERT(reader.tryReadListHead("l", &elementType, &count).has_value());
+            TEST_CHECK(count == 1);
+        }
+    }
+    TEST_CHECK(reader.readInt("leaf") == depth);
+    for (int i = depth - 1; i >= 0; i--) {
+        if (i % 2 == 0) {
+            TEST_ASSERT(reader.tryExitCompound().has_value());
+        }
+    }
+    TEST_CHECK(reader.readInt("after") == 7);
+}
+
+void test_skip_nested(void) {
+    std::vector<int> ints(1000, 7);
+    std::vector<std::byte> data;
+    {
+        NBT::NBTWriter writer(data);
+        writer.writeCompound("skipped");
+        writer.writeListHead("ints", NBT::idInt, 3);
+        writer.writeInt("", 1);
+        writer.writeInt("", 2);
+        writer.writeInt("", 3);
+        writer.writeIntArray("array", ints);
+        writer.writeListHead("lists", NBT::idList, 2);
+        writer.writeListHead("", NBT::idString, 2);
+        writer.writeString("", "a");
+        writer.writeString("", "b");
+        writer.writeListHead("", NBT::idCompound, 1);
+        writer.writeCompound("");
+        writer.writeDouble("d", 2.5);
+        writer.endCompound();
+        writer.writeString("last", "x");
+        writer.endCompound();
+        writer.writeInt("after", 99);
+        writer.close();
+    }
+    {
+        NBT::NBTReader reader(data);
+        reader.skipCurrentTag();
+        TEST_CHECK(reader.readInt("after") == 99);
+    }
+
+    // Lists nested far deeper than the reader's stack are skipped in a loop
+    auto nested = [](int depth) {
+        std::vector<std::byte> bytes = {std::byte{10}, std::byte{0}, std::byte{0},
+                                        std::byte{9}, std::byte{0}, std::byte{1}, std::byte{'l'}};
+        for (int i = 0; i < depth; i++) {
+            bytes.insert(bytes.end(), {std::byte{9}, std::byte{0}, std::byte{0}, std::byte{0}, std::byte{1}});
+        }
+        bytes.insert(bytes.end(), {std::byte{1}, std::byte{0}, std::byte{0}, std::byte{0}, std::byte{2},
+                                   std::byte{5}, std::byte{6}});
+        bytes.insert(bytes.end(), {std::byte{3}, std::byte{0}, std::byte{1}, std::byte{'n'},
+                                   std::byte{0}, std::byte{0}, std::byte{0}, std::byte{42}, std::byte{0}});
+        return bytes;
+    };
+    std::vector<std::byte> deep = nested(400);
+    {
+        NBT::NBTReader reader(deep);
+        TEST_CHECK(reader.trySkipCurrentTag().has_value());
+        TEST_CHECK(reader.readInt("n") == 42);
+    }
+    std::vector<std::byte> tooDeep = nested(VisitDepthLimit);
+    {
+        NBT::NBTReader reader(tooDeep);
+        auto result = reader.trySkipCurrentTag();
+        TEST_CHECK(!result && result.error().code == NBT::ErrorCode::TooDeep);
+    }
+}
+
+// Test error handling - file cut off in the middle of a value
+void test_error_truncated(void) {
+    std::string testfile = get_temp_path("test_truncated.dat");
+
+    // Write test data
+    {
+        NBT::NBTWriter writer(testfile.c_str());
+        writer.writeString("testTag", "a value long enough to cut");
+        writer.endCompound();
+        writer.close();
+    }
+    std::filesystem::resize_file(testfile, 16);
+
+    // Read must stop at the end of the mapping instead of running past it
+    {
+        NBT::NBTReader reader(testfile.c_str());
+
+        bool caught = false;
+        try {
+            reader.readString("testTag");
+        } catch (const std::runtime_error& e) {
+            caught = true;
+            TEST_CHECK(std::string(e.what()).find("Unexpected EOF") != std::string::npos);
+        }
+
+        TEST_CHECK(caught);
+        reader.close();
+    }
+
+    std::remove(testfile.c_str());
+}
+
+// Test that the non-throwing API reports the error code and position
+void test_error_result(void) {
+    std::vector<std::byte> data;
+    {
+        NBT::NBTWriter writer(data);
+        writer.writeInt("count", 7);
+        writer.close();
+    }
+
+    // Header (3) + type (1) + name length (2) + "count" (5)
+    {
+        NBT::NBTReader reader(data);
+        auto value = reader.tryReadInt("total");
+        TEST_CHECK(!value);
+        TEST_CHECK(value.error().code == NBT::ErrorCode::NameMismatch);
+        TEST_CHECK(value.error().offset == 11);
+        TEST_CHECK(value.error().actualName == "count");
+        TEST_CHECK(value.error().message().find("Expected tag name 'total' but got 'count'") != std::string::npos);
+    }
+
+    {
+        NBT::NBTReader reader(data);
+        auto value = reader.tryReadShort("count");
+        TEST_CHECK(!value);
+        TEST_CHECK(value.error().code == NBT::ErrorCode::TypeMismatch);
+        TEST_CHECK(value.error().expectedType == NBT::idShort);
+    }
+
+    {
+        NBT::NBTReader reader(data);
+        auto value = reader.tryReadInt("count");
+        TEST_CHECK(value && *value == 7);
+        TEST_CHECK(reader.tryExitCompound().has_value());
+        auto past = reader.tryReadTagType();
+        TEST_CHECK(!past);
+        TEST_CHECK(past.error().code == NBT::ErrorCode::UnexpectedEof);
+        TEST_CHECK(past.error().offset == data.size());
+    }
+
+    // Opening bad input reports instead of throwing
+    {
+        std::vector<std::byte> garbage(8, std::byte{0x42});
+        NBT::NBTReader reader;
+        auto opened = reader.tryOpen(garbage);
+        TEST_CHECK(!opened);
+        TEST_CHECK(opened.error().code == NBT::ErrorCode::BadHeader);
+    }
+
+    // Names are copied, so the error outlives a gzip reader's window
+    {
+        std::vector<std::byte> gzipped;
+        {
+            NBT::NBTWriter writer(gzipped);
+            writer.setCompression(6);
+            writer.writeInt("count", 7);
+            writer.close();
+        }
+        NBT::Result<int> value = [&] {
+            NBT::NBTReader reader(gzipped);
+            return reader.tryReadInt("total");
+        }();
+        TEST_CHECK(!value);
+        TEST_CHECK(value.error().actualName == "count");
+        TEST_CHECK(value.error().message().find("but got 'count'") != std::string::npos);
+    }
+
+    // A negative array length is rejected before anything is pushed
+    {
+        std::vector<std::byte> negative = {std::byte{10}, std::byte{0}, std::byte{0},
+            std::byte{11}, std::byte{0}, std::byte{1}, std::byte{'a'},
+            std::byte{0xff}, std::byte{0xff}, std::byte{0xff}, std::byte{0xff}};
+        NBT::NBTReader reader(negative);
+        auto head = reader.tryReadIntArrayHead("a");
+        TEST_CHECK(!head && head.error().code == NBT::ErrorCode::NegativeLength);
+    }
+
+    // So is a negative list length
+    {
+        std::vector<std::byte> negative = {std::byte{10}, std::byte{0}, std::byte{0},
+            std::byte{9}, std::byte{0}, std::byte{1}, std::byte{'l'}, std::byte{3},
+            std::byte{0xff}, std::byte{0xff}, std::byte{0xff}, std::byte{0xfe}};
+        NBT::NBTReader reader(negative);
+        char elementType;
+        int count;
+        auto head = reader.tryReadListHead("l", &elementType, &count);
+        TEST_CHECK(!head && head.error().code == NBT::ErrorCode::NegativeLength);
+        TEST_CHECK(!head && head.error().offset == negative.size());
+    }
+}
+
+// Test that buffered writes still report the exact byte count
+void test_writer_byte_count(void) {
+    std::string testfile = get_temp_path("test_byte_count.dat");
+    std::string icon(30000, 'A');
+    unsigned long long written = 0;
+
+    // Write enough data to span several flushed blocks
+    {
+        NBT::NBTWriter writer(testfile.c_str());
+        writer.writeListHead("servers", NBT::idCompound, 5);
+        for (int i = 0; i < 5; i++) {
+            writer.writeCompound("");
+            writer.writeString("icon", icon.c_str() + i * 1000);
+            writer.writeByte("acceptTextures", 1);
+            writer.endCompound();
+        }
+        written = writer.close();
+    }
+
+    TEST_CHECK(written == std::filesystem::file_size(testfile));
+
+    std::remove(testfile.c_str());
+}
+
 TEST_LIST = {
     { "Read primitives", test_read_primitives },
+    { "Read string views", test_read_string_views },
     { "Read compound", test_read_compound },
     { "Read list", test_read_list },
     { "Read string list", test_read_string_list },
@@ -480,5 +1161,17 @@ TEST_LIST = {
     { "Error wrong name", test_error_wrong_name },
     { "Error wrong type", test_error_wrong_type },
     { "Read byte array", test_read_byte_array },
+    { "Bulk arrays", test_bulk_arrays },
+    { "Little endian", test_little_endian },
+    { "Gzip roundtrip", test_gzip_roundtrip },
+    { "Visitor", test_visitor },
+    { "Document", test_document },
+    { "Arena move", test_arena_move },
+    { "Validate", test_validate },
+    { "Deep nesting", test_deep_nesting },
+    { "Skip nested", test_skip_nested },
+    { "Error truncated file", test_error_truncated },
+    { "Error result", test_error_result },
+    { "Writer byte count", test_writer_byte_count },
     { NULL, NULL }
 };
@@ -1,5 +1,6 @@
 #include "acutest.h"
 #include "parse.hpp"
+#include "csv_scan.hpp"
 #include <csetjmp>
 #include <cstdio>
 #include <cstdlib>
@@ -77,6 +78,89 @@ void test_parse_csv_load(void) {
 	TEST_CHECK(output != "csv file content is empty. no servers.dat created\n");
 }
 
+void test_parse_csv_line_edges(void) {
+	std::string output = capture_output([&](){
+		std::vector<nbtserver> servers = parse_servers_csv("A,iconA,1.1.1.1,1\r\n\nB,iconB,2.2.2.2,\nC;iconC;3.3.3.3;0");
+		TEST_CHECK(servers.size() == 2);
+		TEST_CHECK(servers[0].name == "A");
+		TEST_CHECK(servers[0].accept_textures);
+		TEST_CHECK(servers[1].name == "C");
+		TEST_CHECK(servers[1].ip == "3.3.3.3");
+		TEST_CHECK(!servers[1].accept_textures);
+	});
+	// the empty line and the line with a trailing delimiter are both skipped
+	TEST_CHECK(output == "warning: a server entry is missing required fields. it will not be added to the servers list\nwarning: a server entry is missing required fields. it will not be added to the servers list\n");
+}
+
+void test_csv_scan_matches_scalar(void) {
+	const std::string alphabet = "abcXYZ019+/=,|;\n\r ";
+	std::string block(64, 'a');
+	std::srand(1234);
+	for (int round = 0; round < 1000; ++round) {
+		for (char& c : block) {
+			c = alphabet[std::rand() % alphabet.size()];
+		}
+		const csv_block_masks fast = scan_csv_block(block.data());
+		const csv_block_masks reference = scan_csv_block_scalar(block.data());
+		TEST_CHECK_(fast.delims == reference.delims && fast.newlines == reference.newlines,
+			"%s scan differs from scalar", csv_scan_backend());
+	}
+}
+
+void test_parse_csv_long_fields(void) {
+	// fields and line breaks that straddle 64-byte block boundaries
+	std::string csv;
+	for (int i = 0; i < 20; ++i) {
+		csv += "Server" + std::to_string(i) + ",";
+		csv += std::string(60 + i * 7, 'Q') + ",";
+		csv += "10.0.0." + std::to_string(i) + ",";
+		csv += (i % 2 == 0 ? "1" : "0");
+		csv += "\n";
+	}
+	std::vector<nbtserver> servers = parse_servers_csv(csv);
+	TEST_CHECK(servers.size() == 20);
+	for (size_t i = 0; i < servers.size(); ++i) {
+		TEST_CHECK(servers[i].name == "Server" + std::to_string(i));
+		TEST_CHECK(servers[i].icon == std::string(60 + i * 7, 'Q'));
+		TEST_CHECK(servers[i].ip == "10.0.0." + std::to_string(i));
+		TEST_CHECK(servers[i].accept_textures == (i % 2 == 0));
+	}
+}
+
+void test_parse_csv_parallel(void) {
+	// large enough to be split into several chunks
+	constexpr size_t load = 40000;
+	const std::string icon(100, 'I');
+	std::string csv;
+	for (size_t i = 0; i < load; ++i) {
+		if (i % 1000 == 999) {
+			csv += "broken line\n";
+			continue;
+		}
+		csv += "Server" + std::to_string(i) + "," + icon + ",1.0.0.1," + (i % 2 == 0 ? "1" : "0") + "\n";
+	}
+
+	std::vector<nbtserver> servers;
+	std::string output = capture_output([&](){
+		servers = parse_servers_csv(csv, 4);
+	});
+	TEST_CHECK(servers.size() == load - load / 1000);
+
+	// results keep input order across chunk boundaries
+	size_t expected = 0;
+	bool ordered = true;
+	for (const auto& server : servers) {
+		if (expected % 1000 == 999) {
+			++expected;
+		}
+		ordered = ordered && server.name == "Server" + std::to_string(expected)
+			&& server.accept_textures == (expected % 2 == 0);
+		++expected;
+	}
+	TEST_CHECK(ordered);
+	TEST_CHECK(std::count(output.begin(), output.end(), '\n') == load / 1000);
+}
+
 void test_parse_toml_empty(void) {
 	std::string output = capture_output([&](){
 		std::vector<nbtserver> servers = parse_servers_toml("");
@@ -136,6 +220,49 @@ void test_parse_toml_servers_malformed_table(void) {
 	TEST_CHECK(output == "toml file is malformed. validate the syntax and try again\n");
 }
 
+void test_parse_toml_servers_escapes_and_comments(void) {
+	std::string output = capture_output([&](){
+		std::vector<nbtserver> servers = parse_servers_toml(
+			"# exported list\r\n"
+			"[[servers]] # first\r\n"
+			"icon = \"/9j/4AAQ\"\r\n"
+			"ip = '10.0.0.1'\r\n"
+			"name = \"Quote \\\" Tab\\t Caf\\u00e9\"   # trailing comment\r\n"
+			"accept_textures = false\r\n");
+		TEST_CHECK(servers.size() == 1);
+		TEST_CHECK(servers[0].ip == "10.0.0.1");
+		TEST_CHECK(servers[0].name == "Quote \" Tab\t Caf\xc3\xa9");
+		TEST_CHECK(!servers[0].accept_textures);
+	});
+	TEST_CHECK(output.empty());
+}
+
+void test_parse_toml_servers_unusual_layout(void) {
+	// extra keys and inline tables are left to the full toml parser
+	std::string output = capture_output([&](){
+		std::vector<nbtserver> servers = parse_servers_toml(R"(
+			title = "my servers"
+			[[servers]]
+			icon = "icon1"
+			ip = "1.1.1.1"
+			name = "Server One"
+			port = 25565
+			accept_textures = true
+
+			[[servers]]
+			icon = "icon2"
+			ip = "2.2.2.2"
+			name = """Multi
+line"""
+		)");
+		TEST_CHECK(servers.size() == 2);
+		TEST_CHECK(servers[0].accept_textures);
+		TEST_CHECK(servers[1].name == "Multi\nline");
+		TEST_CHECK(!servers[1].accept_textures);
+	});
+	TEST_CHECK(output.empty());
+}
+
 void test_parse_json_empty(void) {
 	std::string output = capture_output([&](){
 		std::vector<nbtserver> servers = parse_servers_json("");
@@ -235,23 +362,59 @@ void test_parse_json_servers_parse(void) {
 	TEST_CHECK(output.empty());
 }
 
+void test_parse_json_servers_parse_wrong_types(void) {
+	std::string output = capture_output([&](){
+		std::vector<nbtserver> servers = parse_servers_json(R"(
+			{
+			  "servers": [
+			    {
+			      "icon": "icon1",
+			      "ip": 1234,
+			      "name": "name1",
+			      "accept_textures": true
+			    },
+			    "not a server",
+			    {
+			      "icon": "icon2",
+			      "ip": "ip2",
+			      "name": "name2",
+			      "extra": { "ip": "nested" },
+			      "accept_textures": false
+			    }
+			  ],
+			  "other": [ { "ip": "ignored" } ]
+			}
+		)");
+		TEST_CHECK(servers.size() == 1);
+		TEST_CHECK(servers[0].ip == "ip2");
+		TEST_CHECK(!servers[0].accept_textures);
+	});
+	TEST_CHECK(output == "warning: a server entry is missing required fields. it will not be added to the servers list\nwarning: a server entry is missing required fields. it will not be added to the servers list\n");
+}
 
 TEST_LIST = {
    { "Parse CSV - empty", test_parse_csv_empty },
    { "Parse CSV - delims", test_parse_csv_delims },
    { "Parse CSV - load", test_parse_csv_load },
    { "Parse CSV - missing property", test_parse_csv_missing_property },
+   { "Parse CSV - line edges", test_parse_csv_line_edges },
+   { "Parse CSV - long fields", test_parse_csv_long_fields },
+   { "Parse CSV - parallel", test_parse_csv_parallel },
+   { "CSV scan - matches scalar", test_csv_scan_matches_scalar },
    { "Parse TOML - empty", test_parse_toml_empty },
    { "Parse TOML - when servers is not a table", test_parse_toml_servers_not_a_table },
    { "Parse TOML - missing property", test_parse_toml_servers_entry_missing_property },
    { "Parse TOML - parse", test_parse_toml_servers_parse },
    { "Parse TOML - when servers is malformed table", test_parse_toml_servers_malformed_table },
+   { "Parse TOML - escapes and comments", test_parse_toml_servers_escapes_and_comments },
+   { "Parse TOML - unusual layout", test_parse_toml_servers_unusual_layout },
    { "Parse JSON - empty", test_parse_json_empty },
    { "Parse JSON - malformed object", test_parse_json_malformed_object },
    { "Parse JSON - missing servers key", test_parse_json_servers_missing_servers },
    { "Parse JSON - servers key but not an array", test_parse_json_servers_not_an_array },
    { "Parse JSON - parse skip malformed", test_parse_json_servers_parse_skipping_malformed },
    { "Parse JSON - parse", test_parse_json_servers_parse },
+   { "Parse JSON - parse skip wrong field types", test_parse_json_servers_parse_wrong_types },
    { NULL, NULL }
 };
 
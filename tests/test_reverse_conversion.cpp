@@ -347,6 +347,191 @@ void test_special_characters(void) {
     std::remove(dat_file.c_str());
 }
 
+// Test entries with reordered, missing and extra tags as in vanilla files
+void test_parse_dat_vanilla_layout(void) {
+    std::vector<std::byte> dat;
+    {
+        NBT::NBTWriter writer(dat);
+        writer.writeListHead("servers", NBT::idCompound, 3);
+
+        // reordered, no icon, extra hidden flag
+        writer.writeCompound("");
+        writer.writeString("ip", "10.2.0.1");
+        writer.writeByte("hidden", 0);
+        writer.writeString("name", "NoIcon");
+        writer.writeByte("acceptTextures", 1);
+        writer.endCompound();
+
+        // unknown nested data and a mistyped acceptTextures
+        writer.writeCompound("");
+        writer.writeCompound("extra");
+        writer.writeString("name", "not this one");
+        writer.endCompound();
+        writer.writeListHead("tags", NBT::idString, 1);
+        writer.writeString("", "tag");
+        writer.writeInt("acceptTextures", 1);
+        writer.writeString("icon", "iconX");
+        writer.writeString("name", "Extras");
+        writer.writeString("ip", "10.2.0.2");
+        writer.endCompound();
+
+        // missing ip is still rejected
+        writer.writeCompound("");
+        writer.writeString("name", "NoIp");
+        writer.endCompound();
+
+        writer.endCompound();
+        writer.close();
+    }
+
+    std::vector<nbtserver> servers = parse_servers_dat(std::span<const std::byte>(dat));
+    TEST_CHECK(servers.size() == 2);
+    TEST_CHECK(servers[0].name == "NoIcon");
+    TEST_CHECK(servers[0].icon.empty());
+    TEST_CHECK(servers[0].ip == "10.2.0.1");
+    TEST_CHECK(servers[0].accept_textures == true);
+    TEST_CHECK(servers[1].name == "Extras");
+    TEST_CHECK(servers[1].icon == "iconX");
+    TEST_CHECK(servers[1].ip == "10.2.0.2");
+    TEST_CHECK(servers[1].accept_textures == false);
+}
+
+// Test DAT roundtrip entirely in memory
+void test_in_memory_roundtrip(void) {
+    std::vector<nbtserver> original = {
+        {"iconM", "10.1.1.1", "Memory1", true},
+        {"iconN", "10.1.1.2", "Memory2", false}
+    };
+
+    // Write to a byte buffer instead of a file
+    std::vector<std::byte> dat;
+    {
+        NBT::NBTWriter writer(dat);
+        writer.writeListHead("servers", NBT::idCompound, original.size());
+        for (const auto& server : original) {
+            writer.writeCompound("");
+            writer.writeString("name", server.name.data());
+            writer.writeString("icon", server.icon.data());
+            writer.writeString("ip", server.ip.data());
+            writer.writeByte("acceptTextures", server.accept_textures);
+            writer.endCompound();
+        }
+        writer.endCompound();
+        TEST_CHECK(writer.close() == dat.size());
+    }
+
+    // Read back from the same buffer
+    std::vector<nbtserver> servers = parse_servers_dat(std::span<const std::byte>(dat));
+    TEST_CHECK(servers.size() == 2);
+    TEST_CHECK(servers[0].name == "Memory1");
+    TEST_CHECK(servers[0].icon == "iconM");
+    TEST_CHECK(servers[0].accept_textures == true);
+    TEST_CHECK(servers[1].ip == "10.1.1.2");
+    TEST_CHECK(servers[1].accept_textures == false);
+}
+
+// Bedrock files are little-endian with an optional level.dat header
+void test_bedrock_roundtrip(void) {
+    std::vector<nbtserver> original = {
+        {"iconB", "10.2.2.1", "Bedrock1", true},
+        {"iconC", "10.2.2.2", "Bedrock2", false}
+    };
+    const auto write = [&](NBT::NBTWriterLE& writer) {
+        writer.writeListHead("servers", NBT::idCompound, original.size());
+        for (const auto& server : original) {
+            writer.writeCompound("");
+            writer.writeString("name", server.name.data());
+            writer.writeString("icon", server.icon.data());
+            writer.writeString("ip", server.ip.data());
+            writer.writeByte("acceptTextures", server.accept_textures);
+            writer.endCompound();
+        }
+        writer.close();
+    };
+
+    std::vector<std::byte> plain, framed;
+    {
+        NBT::NBTWriterLE writer(plain);
+        write(writer);
+    }
+    {
+        NBT::NBTWriterLE writer(framed);
+        writer.writeBedrockHeader(10);
+        write(writer);
+    }
+
+    // Header: version 10, then the length of everything after it
+    TEST_CHECK(framed.size() == plain.size() + 8);
+    TEST_CHECK(framed[0] == std::byte{10} && framed[1] == std::byte{0});
+    TEST_CHECK(static_cast<size_t>(framed[4]) + (static_cast<size_t>(framed[5]) << 8) == plain.size());
+
+    for (const auto* dat : {&plain, &framed}) {
+        std::vector<nbtserver> servers = parse_servers_dat(std::span<const std::byte>(*dat), nbt_flavor::bedrock);
+        TEST_CHECK(servers.size() == 2);
+        TEST_CHECK(servers[0].name == "Bedrock1");
+        TEST_CHECK(servers[1].ip == "10.2.2.2");
+        TEST_CHECK(servers[1].accept_textures == false);
+    }
+
+    // The Java reader rejects the little-endian data
+    TEST_CHECK(parse_servers_dat(std::span<const std::byte>(plain)).empty());
+
+    // Header patched in a file after the data was flushed
+    std::string testfile = get_temp_path("test_bedrock.dat");
+    {
+        NBT::NBTWriterLE writer(testfile.c_str());
+        writer.writeBedrockHeader(10);
+        write(writer);
+    }
+    TEST_CHECK(std::filesystem::file_size(testfile) == framed.size());
+    TEST_CHECK(parse_servers_dat(testfile, nbt_flavor::bedrock).size() == 2);
+    std::remove(testfile.c_str());
+}
+
+// Large files are split across threads; the result must match one thread
+void test_parallel_decode(void) {
+    std::vector<std::byte> dat;
+    {
+        NBT::NBTWriter writer(dat);
+        writer.writeListHead("servers", NBT::idCompound, 600);
+        for (int i = 0; i < 600; i++) {
+            std::string name = "Server" + std::to_string(i);
+            std::string ip = "10.0." + std::to_string(i / 256) + "." + std::to_string(i % 256);
+            std::string icon(1000 + (i * 37) % 8000, static_cast<char>('A' + i % 26));
+            writer.writeCompound("");
+            writer.writeString("icon", icon.c_str());
+            writer.writeByte("hidden", 0);
+            // Every 50th entry lacks its ip and is skipped
+            if (i % 50 != 7) {
+                writer.writeString("ip", ip.c_str());
+            }
+            writer.writeString("name", name.c_str());
+            writer.writeByte("acceptTextures", i % 3 == 0);
+            writer.endCompound();
+        }
+        writer.close();
+    }
+    TEST_ASSERT(dat.size() > 2 * (1 << 20));
+
+    std::vector<nbtserver> sequential = parse_servers_dat(std::span<const std::byte>(dat), nbt_flavor::java, 1);
+    TEST_CHECK(sequential.size() == 588);
+    for (unsigned threads : {2u, 3u, 8u}) {
+        std::vector<nbtserver> parallel = parse_servers_dat(std::span<const std::byte>(dat), nbt_flavor::java, threads);
+        TEST_ASSERT(parallel.size() == sequential.size());
+        bool same = true;
+        for (size_t i = 0; i < parallel.size(); i++) {
+            same = same && parallel[i].name == sequential[i].name && parallel[i].ip == sequential[i].ip
+                && parallel[i].icon == sequential[i].icon && parallel[i].accept_textures == sequential[i].accept_textures;
+        }
+        TEST_CHECK_(same, "%u threads", threads);
+    }
+    TEST_CHECK(sequential[7].name == "Server8");
+
+    // A truncated file still fails the whole parse, as with one thread
+    std::vector<std::byte> bad(dat.begin(), dat.end() - 100);
+    TEST_CHECK(parse_servers_dat(std::span<const std::byte>(bad), nbt_flavor::java, 4).empty());
+}
+
 TEST_LIST = {
     { "Full CSV roundtrip", test_full_csv_roundtrip },
     { "Full JSON roundtrip", test_full_json_roundtrip },
@@ -357,5 +542,9 @@ TEST_LIST = {
     { "Large server list", test_large_server_list },
     { "Empty server list", test_empty_server_list },
     { "Special characters", test_special_characters },
+    { "In-memory roundtrip", test_in_memory_roundtrip },
+    { "Parse DAT vanilla layout", test_parse_dat_vanilla_layout },
+    { "Bedrock roundtrip", test_bedrock_roundtrip },
+    { "Parallel decode", test_parallel_decode },
     { NULL, NULL }
 };
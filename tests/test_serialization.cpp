@@ -95,6 +95,81 @@ void test_serialize_json_utf8(void) {
                json_str.find("Servidor") != std::string::npos);
 }
 
+// Test streamed JSON keeps the layout of nlohmann's dump(2)
+void test_serialize_json_stream_layout(void) {
+    std::vector<nbtserver> servers = {
+        {"iconA", "10.0.0.1", "Quote \" and \\ backslash", true},
+        {"iconB", "10.0.0.2", "Tab\tNewline\n", false}
+    };
+
+    using json = nlohmann::json;
+    json expected;
+    expected["servers"] = json::array();
+    for (const auto& server : servers) {
+        json entry;
+        entry["icon"] = server.icon;
+        entry["ip"] = server.ip;
+        entry["name"] = server.name;
+        entry["accept_textures"] = server.accept_textures;
+        expected["servers"].push_back(entry);
+    }
+
+    std::ostringstream out;
+    server_serializer serializer(out, "json");
+    for (const auto& server : servers) {
+        serializer.write(server);
+    }
+    serializer.finish();
+
+    TEST_CHECK(out.str() == expected.dump(2));
+    json empty;
+    empty["servers"] = json::array();
+    TEST_CHECK(serialize_servers_json(std::vector<nbtserver>{}) == empty.dump(2));
+}
+
+// Test compact JSON matches nlohmann's dump() and parses back
+void test_serialize_json_compact(void) {
+    std::vector<nbtserver> servers = {
+        {"iconA", "10.0.0.1", std::string("Ctrl\x01\x1f ") + "\xc3\xa9", true},
+        {"iconB", "10.0.0.2", "ServerB", false}
+    };
+
+    std::string json_str = serialize_servers_json(servers, json_layout::compact);
+    TEST_CHECK(json_str.find('\n') == std::string::npos);
+    TEST_CHECK(json_str.find("\\u0001\\u001f") != std::string::npos);
+
+    using json = nlohmann::json;
+    json parsed = json::parse(json_str);
+    TEST_CHECK(parsed.dump() == json_str);
+    TEST_CHECK(parsed["servers"][0]["name"] == servers[0].name);
+
+    std::vector<nbtserver> roundtrip = parse_servers_json(json_str);
+    TEST_CHECK(roundtrip.size() == 2);
+    TEST_CHECK(roundtrip[1].name == "ServerB");
+}
+
+// Invalid UTF-8 throws, as nlohmann's dump() does, instead of being copied
+// into a document JSON parsers reject; valid multi-byte text passes through
+void test_serialize_json_invalid_utf8(void) {
+    using json = nlohmann::json;
+    const std::string valid = "\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80";
+    std::vector<nbtserver> servers = {{"icon", "10.0.0.1", valid, true}};
+    json expected;
+    expected["servers"] = json::array();
+    expected["servers"].push_back({{"icon", "icon"}, {"ip", "10.0.0.1"}, {"name", valid}, {"accept_textures", true}});
+    TEST_CHECK(serialize_servers_json(servers, json_layout::compact) == expected.dump());
+
+    const std::string invalid[] = {
+        "bad \xff byte", "truncated \xc3", "overlong \xc0\xaf",
+        "surrogate \xed\xa0\x80", "past max \xf4\x90\x80\x80"
+    };
+    for (const std::string& name : invalid) {
+        servers[0].name = name;
+        TEST_EXCEPTION(serialize_servers_json(servers), std::invalid_argument);
+        TEST_EXCEPTION(json(name).dump(), json::type_error);
+    }
+}
+
 // Test TOML serialization
 void test_serialize_toml(void) {
     std::vector<nbtserver> servers = {
@@ -227,6 +302,9 @@ TEST_LIST = {
     { "Serialize JSON", test_serialize_json },
     { "Serialize JSON empty", test_serialize_json_empty },
     { "Serialize JSON UTF-8", test_serialize_json_utf8 },
+    { "Serialize JSON stream layout", test_serialize_json_stream_layout },
+    { "Serialize JSON compact", test_serialize_json_compact },
+    { "Serialize JSON invalid UTF-8", test_serialize_json_invalid_utf8 },
     { "Serialize TOML", test_serialize_toml },
     { "Serialize TOML empty", test_serialize_toml_empty },
     { "Serialize TOML booleans", test_serialize_toml_booleans },
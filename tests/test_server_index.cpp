@@ -0,0 +1,269 @@
+#include "acutest.h"
+#include "NBTReader.h"
+#include "NBTWriter.h"
+#include "parse.hpp"
+#include "server_index.hpp"
+#include <filesystem>
+#include <fstream>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+static std::string get_temp_path(const char* filename) {
+    std::filesystem::path temp = std::filesystem::temp_directory_path();
+    return (temp / filename).string();
+}
+
+// Entries carry an unknown tag and fields in varying order; entry 2 has no ip
+template <typename Writer>
+static void write_servers(Writer& writer, int count) {
+    writer.writeListHead("servers", NBT::idCompound, count);
+    for (int i = 0; i < count; i++) {
+        std::string name = "Server" + std::to_string(i);
+        std::string ip = "10.0.0." + std::to_string(i);
+        writer.writeCompound("");
+        if (i % 2 == 0) {
+            writer.writeByte("hidden", 0);
+            writer.writeString("icon", std::string(100 + i, 'i').c_str());
+        }
+        if (i != 2) {
+            writer.writeString("ip", ip.c_str());
+        }
+        writer.writeString("name", name.c_str());
+        writer.writeByte("acceptTextures", i % 2);
+        writer.endCompound();
+    }
+    writer.close();
+}
+
+static void check_entries(const server_index& index, int count) {
+    TEST_ASSERT(index.size() == static_cast<std::size_t>(count));
+    for (int i = 0; i < count; i++) {
+        std::string name = "Server" + std::to_string(i);
+        TEST_CHECK(index.name(i) == name);
+        TEST_CHECK(index.ip(i) == (i == 2 ? "" : "10.0.0." + std::to_string(i)));
+        TEST_CHECK(index.icon(i) == (i % 2 == 0 ? std::string(100 + i, 'i') : ""));
+        TEST_CHECK(index.accept_textures(i) == (i % 2 == 1));
+    }
+    auto server = index.read(4);
+    TEST_ASSERT(server.has_value());
+    TEST_CHECK(server->name == "Server4");
+    TEST_CHECK(server->ip == "10.0.0.4");
+    TEST_CHECK(server->icon == std::string(104, 'i'));
+    TEST_CHECK(!server->accept_textures);
+    server = index.read(count - 1);
+    TEST_ASSERT(server.has_value());
+    TEST_CHECK(server->name == "Server" + std::to_string(count - 1));
+    TEST_CHECK(server->icon.empty());
+    TEST_CHECK(server->accept_textures);
+
+    // Entries tile the list: each starts where the previous one ended
+    for (int i = 1; i < count; i++) {
+        TEST_CHECK(index.offsets(i).offset == index.offsets(i - 1).offset + index.offsets(i - 1).length);
+    }
+}
+
+void test_index_on_the_fly(void) {
+    std::string path = get_temp_path("test_index.dat");
+    std::remove(server_index_path(path).c_str());
+    {
+        NBT::NBTWriter writer(path.c_str());
+        write_servers(writer, 50);
+    }
+
+    server_index index;
+    TEST_ASSERT(index.open(path));
+    check_entries(index, 50);
+    TEST_CHECK(!std::filesystem::exists(server_index_path(path)));
+
+    std::remove(path.c_str());
+}
+
+void test_index_persisted(void) {
+    std::string path = get_temp_path("test_index_persist.dat");
+    std::remove(server_index_path(path).c_str());
+    {
+        NBT::NBTWriter writer(path.c_str());
+        write_servers(writer, 20);
+    }
+
+    {
+        server_index index;
+        TEST_ASSERT(index.open(path, nbt_flavor::java, true));
+        check_entries(index, 20);
+    }
+    TEST_CHECK(std::filesystem::exists(server_index_path(path)));
+    {
+        server_index index;
+        TEST_ASSERT(index.open(path));
+        check_entries(index, 20);
+    }
+
+    // A changed file makes the sidecar stale, so it is rebuilt
+    {
+        NBT::NBTWriter writer(path.c_str());
+        write_servers(writer, 30);
+    }
+    {
+        server_index index;
+        TEST_ASSERT(index.open(path, nbt_flavor::java, true));
+        check_entries(index, 30);
+    }
+
+    std::remove(path.c_str());
+    std::remove(server_index_path(path).c_str());
+}
+
+void test_index_gzip_and_bedrock(void) {
+    std::string path = get_temp_path("test_index_gzip.dat");
+    {
+        NBT::NBTWriter writer(path.c_str());
+        writer.setCompression(6);
+        write_servers(writer, 40);
+    }
+    {
+        server_index index;
+        TEST_ASSERT(index.open(path));
+        check_entries(index, 40);
+    }
+
+    {
+        NBT::NBTWriterLE writer(path.c_str());
+        writer.writeBedrockHeader(10);
+        write_servers(writer, 40);
+    }
+    {
+        server_index index;
+        TEST_ASSERT(index.open(path, nbt_flavor::bedrock));
+        check_entries(index, 40);
+    }
+    std::remove(path.c_str());
+}
+
+void test_index_seek_requires_raw_input(void) {
+    std::vector<std::byte> data;
+    {
+        NBT::NBTWriter writer(data);
+        writer.setCompression(1);
+        write_servers(writer, 3);
+    }
+    NBT::NBTReader reader(data);
+    auto result = reader.trySeekCompound(3);
+    TEST_CHECK(!result && result.error().code == NBT::ErrorCode::NotSeekable);
+}
+
+// A damaged sidecar is ignored and rebuilt rather than trusted
+void test_index_corrupt_sidecar(void) {
+    std::string path = get_temp_path("test_index_corrupt.dat");
+    std::remove(server_index_path(path).c_str());
+    {
+        NBT::NBTWriter writer(path.c_str());
+        write_servers(writer, 8);
+    }
+    {
+        server_index index;
+        TEST_ASSERT(index.open(path, nbt_flavor::java, true));
+    }
+
+    // Magic and stamp take 40 bytes; the first entry's length follows its offset
+    const std::uint64_t huge = ~std::uint64_t{0} - 4;
+    {
+        std::fstream sidecar(server_index_path(path), std::ios::binary | std::ios::in | std::ios::out);
+        sidecar.seekp(40 + sizeof(std::uint64_t));
+        sidecar.write(reinterpret_cast<const char*>(&huge), sizeof(huge));
+    }
+    {
+        server_index index;
+        TEST_ASSERT(index.open(path, nbt_flavor::java, true));
+        check_entries(index, 8);
+    }
+
+    // A count the file doesn't back is rejected before anything is read
+    {
+        std::fstream sidecar(server_index_path(path), std::ios::binary | std::ios::in | std::ios::out);
+        sidecar.seekp(32);
+        sidecar.write(reinterpret_cast<const char*>(&huge), sizeof(huge));
+    }
+    {
+        server_index index;
+        TEST_ASSERT(index.open(path));
+        check_entries(index, 8);
+    }
+
+    std::remove(path.c_str());
+    std::remove(server_index_path(path).c_str());
+}
+
+// Errors carry their own copy of names, so they outlive the scan's reader
+void test_index_scan_errors(void) {
+    std::vector<std::byte> data;
+    {
+        NBT::NBTWriter writer(data);
+        writer.writeListHead("players", NBT::idCompound, 0);
+        writer.close();
+    }
+    auto scanned = scan_server_index(data);
+    TEST_ASSERT(!scanned);
+    TEST_CHECK(scanned.error().code == NBT::ErrorCode::NameMismatch);
+    TEST_CHECK(scanned.error().message().find("but got 'players'") != std::string::npos);
+
+    std::vector<std::byte> gzipped;
+    {
+        NBT::NBTWriter writer(gzipped);
+        writer.setCompression(6);
+        writer.writeListHead("players", NBT::idCompound, 0);
+        writer.close();
+    }
+    scanned = scan_server_index(gzipped);
+    TEST_CHECK(!scanned && scanned.error().code == NBT::ErrorCode::NotSeekable);
+}
+
+void test_server_list_view(void) {
+    std::string path = get_temp_path("test_list_view.dat");
+    {
+        NBT::NBTWriter writer(path.c_str());
+        write_servers(writer, 10);
+    }
+
+    server_list_view view;
+    TEST_ASSERT(view.open(path));
+    TEST_CHECK(view.size() == 10);
+    int i = 0;
+    int complete = 0;
+    for (server_view server : view) {
+        TEST_CHECK(server.name() == "Server" + std::to_string(i));
+        complete += server.complete();
+        ++i;
+    }
+    TEST_CHECK(i == 10);
+    TEST_CHECK(complete == 9);
+
+    // Views point into the mapping rather than at copies
+    server_view fourth = view[4];
+    TEST_CHECK(fourth.icon().size() == 104);
+    nbtserver copy = fourth.to_server();
+    TEST_CHECK(copy.ip == "10.0.0.4");
+    TEST_CHECK(copy.icon == std::string(104, 'i'));
+    TEST_CHECK(!copy.accept_textures);
+    TEST_CHECK(view[2].ip().empty());
+
+    // Moving the list leaves views taken from it valid
+    server_view first = view[0];
+    server_list_view moved = std::move(view);
+    TEST_CHECK(first.name() == "Server0");
+    TEST_CHECK(moved.size() == 10);
+    TEST_CHECK(moved[9].name() == "Server9");
+
+    std::remove(path.c_str());
+}
+
+TEST_LIST = {
+    { "Index on the fly", test_index_on_the_fly },
+    { "Index persisted", test_index_persisted },
+    { "Index gzip and Bedrock", test_index_gzip_and_bedrock },
+    { "Seek requires raw input", test_index_seek_requires_raw_input },
+    { "Index corrupt sidecar", test_index_corrupt_sidecar },
+    { "Index scan errors", test_index_scan_errors },
+    { "Server list view", test_server_list_view },
+    { NULL, NULL }
+};